@@ -0,0 +1,87 @@
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace std;
+
+namespace Bench {
+    
+    template <template <typename> class NodeAllocator>
+    void benchAVLTreeAllocator(const string& name, const vector<Student>& sorted,
+                               const vector<Student>& randomOrder, int lookups) {
+        double sink = 0;
+        
+        {
+            AVLTree<Student, StudentIdKey, less<>, NodeAllocator> tree;
+            printResult(name + ": load (sorted IDs)",
+                        timeMs([&] { for (const Student& s : sorted) tree.insert(s); }), "ms");
+        }
+        
+        AVLTree<Student, StudentIdKey, less<>, NodeAllocator> tree;
+        printResult(name + ": load (random IDs)",
+                    timeMs([&] { for (const Student& s : randomOrder) tree.insert(s); }), "ms");
+        
+        mt19937 rng(1);
+        vector<Student> probes;
+        probes.reserve(lookups);
+        for (int i = 0; i < lookups; ++i) {
+            probes.push_back(sorted[rng() % sorted.size()]);
+        }
+        
+        double lookupMs = timeMs([&] {
+            for (const Student& probe : probes) {
+                const Student* found = tree.find(probe);
+                if (found) sink += found->getAge();
+            }
+        });
+        printResult(name + ": lookup latency", lookupMs * 1e6 / lookups, "ns/op");
+        
+        double removeMs = timeMs([&] {
+            for (size_t i = 0; i < randomOrder.size(); i += 2) tree.remove(randomOrder[i]);
+        });
+        printResult(name + ": remove half", removeMs, "ms");
+        
+        double reinsertMs = timeMs([&] {
+            for (size_t i = 0; i < randomOrder.size(); i += 2) tree.insert(randomOrder[i]);
+        });
+        printResult(name + ": re-insert half (free-list reuse)", reinsertMs, "ms");
+        
+        printResult(name + ": teardown", timeMs([&] { tree.clear(); }), "ms");
+        
+        if (sink < 0) cout << sink << endl;
+    }
+    
+    void benchAVLTreeBulkLoad(const vector<Student>& sorted, const vector<Student>& randomOrder) {
+        {
+            AVLTree<Student, StudentIdKey> tree;
+            printResult("insert one by one (sorted IDs)",
+                        timeMs([&] { for (const Student& s : sorted) tree.insert(s); }), "ms");
+        }
+        {
+            AVLTree<Student, StudentIdKey> tree;
+            vector<Student> copy = sorted;
+            printResult("buildFrom (sorted IDs)",
+                        timeMs([&] { tree.buildFrom(move(copy)); }), "ms");
+        }
+        {
+            AVLTree<Student, StudentIdKey> tree;
+            vector<Student> copy = randomOrder;
+            printResult("buildFrom (random IDs, sort fallback)",
+                        timeMs([&] { tree.buildFrom(move(copy)); }), "ms");
+        }
+    }
+    
+    void runAVLTreeBench(int count) {
+        printHeader("AVLTree node allocation (" + to_string(count) + " students)");
+        
+        vector<Student> sorted = makeStudents(count);
+        vector<Student> randomOrder = shuffled(sorted);
+        int lookups = 1000000;
+        
+        benchAVLTreeAllocator<HeapAllocator>("heap", sorted, randomOrder, lookups);
+        benchAVLTreeAllocator<PoolAllocator>("pool", sorted, randomOrder, lookups);
+        
+        printHeader("AVLTree bulk load (" + to_string(count) + " students)");
+        benchAVLTreeBulkLoad(sorted, randomOrder);
+    }
+}
@@ -0,0 +1,60 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+
+using namespace std;
+
+namespace Bench {
+    
+    // Type-ahead for one prefix through StudentManager::autocomplete (radix
+    // tries plus the ID index) and through a scan of the roster that stops
+    // once it has `limit` students.
+    template <typename Manager>
+    void benchPrefix(const Manager& manager, const string& prefix, int limit) {
+        const int rounds = 2000;
+        size_t suggestions = 0;
+        double trieMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) suggestions = manager.autocomplete(prefix, limit).size();
+        });
+        
+        string folded = Utils::toLower(prefix);
+        auto startsWith = [&](const string& text) { return text.compare(0, folded.size(), folded) == 0; };
+        size_t scanned = 0;
+        double scanMs = timeMs([&] {
+            for (int i = 0; i < rounds / 100; ++i) {
+                scanned = 0;
+                for (const Student& s : manager.getStudentStore()) {
+                    if (startsWith(s.getId()) || startsWith(s.getFirstNameKey()) ||
+                        startsWith(s.getLastNameKey())) {
+                        if (++scanned == static_cast<size_t>(limit)) break;
+                    }
+                }
+            }
+        });
+        
+        string label = "'" + prefix + "' (" + to_string(suggestions) + " of " + to_string(limit) + ")";
+        printResult(label + ": tries", trieMs * 1000 / rounds, "us");
+        printResult(label + ": scan", scanMs * 1000 / (rounds / 100), "us");
+    }
+    
+    void runAutocompleteBench(int count) {
+        printHeader("Autocomplete (" + to_string(count) + " students)");
+        vector<Student> sorted = makeStudents(count);
+        randomizeNames(sorted);
+        
+        string studentsFile = "bench_students.csv";
+        string coursesFile = "bench_courses.csv";
+        writeRosterFiles(sorted, studentsFile, coursesFile);
+        
+        {
+            StudentManager manager(studentsFile, coursesFile);
+            for (const string& prefix : vector<string>{"00012", "a", "fi", "fikre", "kreri", "zeze", "qq"}) {
+                benchPrefix(manager, prefix, 10);
+            }
+            benchPrefix(manager, "ma", 100);
+        }
+        
+        remove(studentsFile.c_str());
+        remove(coursesFile.c_str());
+    }
+}
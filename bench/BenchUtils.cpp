@@ -0,0 +1,110 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+
+using namespace std;
+
+namespace Bench {
+    
+    // Runs `fn` once and returns the wall-clock time in milliseconds.
+    template <typename Fn>
+    double timeMs(Fn&& fn) {
+        auto start = chrono::steady_clock::now();
+        fn();
+        auto end = chrono::steady_clock::now();
+        return chrono::duration<double, milli>(end - start).count();
+    }
+    
+    string makeId(int n) {
+        stringstream ss;
+        ss << setw(7) << setfill('0') << n;
+        return ss.str();
+    }
+    
+    // Synthetic roster with unique IDs 0..count-1, returned in sorted ID order
+    // (the order the CSV file is written in).
+    vector<Student> makeStudents(int count, unsigned seed = 42) {
+        static const vector<string> firstNames = {
+            "Abebe", "Almaz", "Dawit", "Fikremariam", "Firaol", "Hana", "Kebede",
+            "Liya", "Meron", "Naod", "Selam", "Tigist", "Yonas", "Zewdu"
+        };
+        static const vector<string> lastNames = {
+            "Alemu", "Bekele", "Debela", "Gula", "Haile", "Kassa", "Mekonnen",
+            "Negash", "Tadesse", "Wolde", "Yilma"
+        };
+        static const vector<string> departments = {"SE", "CS", "EE", "ME", "CE"};
+        static const vector<string> sections = {"A", "B", "C", "D"};
+        
+        mt19937 rng(seed);
+        vector<Student> students;
+        students.reserve(count);
+        
+        for (int i = 0; i < count; ++i) {
+            Student student(makeId(i), "password",
+                            firstNames[rng() % firstNames.size()],
+                            lastNames[rng() % lastNames.size()],
+                            departments[rng() % departments.size()],
+                            17 + rng() % 14, (rng() % 2) ? 'M' : 'F',
+                            1 + rng() % 5, sections[rng() % sections.size()]);
+            student.setGPA((rng() % 401) / 100.0);
+            students.push_back(student);
+        }
+        
+        return students;
+    }
+    
+    // Replaces the names with random runs of syllables. makeStudents() draws
+    // from a handful of names; this gives tens of thousands of distinct ones,
+    // as in a real roster.
+    void randomizeNames(vector<Student>& students, unsigned seed = 7) {
+        static const vector<string> syllables = {
+            "a", "ab", "al", "am", "be", "da", "de", "fi", "gu", "ha", "ke", "kre", "la",
+            "li", "ma", "me", "na", "ne", "od", "ri", "se", "ta", "ti", "wo", "yo", "ze"
+        };
+        mt19937 rng(seed);
+        auto randomName = [&] {
+            string name;
+            for (int parts = 2 + rng() % 4; parts > 0; --parts) {
+                name += syllables[rng() % syllables.size()];
+            }
+            name[0] = toupper(name[0]);
+            return name;
+        };
+        
+        for (Student& student : students) {
+            student.setFirstName(randomName());
+            student.setLastName(randomName());
+        }
+    }
+    
+    // StudentManager loads from and saves to CSV files, so benchmarks that
+    // need a whole manager give it scratch copies written here.
+    void writeRosterFiles(const vector<Student>& students, const string& studentsFile,
+                          const string& coursesFile) {
+        ofstream studentsOut(studentsFile);
+        studentsOut << "id,password_hash,first_name,last_name,department,age,sex,year_of_study,section,course_results" << endl;
+        for (const Student& s : students) studentsOut << s.toCSV() << endl;
+        
+        ofstream coursesOut(coursesFile);
+        coursesOut << "department,year_of_study,course_code,course_name,credit_hours" << endl;
+    }
+    
+    vector<Student> shuffled(vector<Student> students, unsigned seed = 7) {
+        shuffle(students.begin(), students.end(), mt19937(seed));
+        return students;
+    }
+    
+    void printHeader(const string& title) {
+        cout << "\n== " << title << " ==" << endl;
+    }
+    
+    void printResult(const string& label, double value, const string& unit) {
+        cout << "  " << left << setw(44) << label << right << setw(12)
+             << fixed << setprecision(2) << value << " " << unit << endl;
+    }
+}
@@ -0,0 +1,126 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+namespace Bench {
+    
+    // One filter over the columnar copy and over the Student records, both
+    // producing the matching rows in ID order.
+    void benchColumnFilter(const string& name, const vector<Student>& students,
+                           const StudentColumns& columns, const SearchCriteria& criteria,
+                           SearchMode mode = SearchMode::MATCH_ALL) {
+        const int rounds = 10;
+        vector<SearchField> fields = SearchManager::activeFields(criteria);
+        vector<const Student*> matches;
+        
+        double rowMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                matches.clear();
+                for (const Student& s : students) {
+                    if (SearchManager::matchesFields(s, criteria, fields, mode)) matches.push_back(&s);
+                }
+            }
+        });
+        size_t rowMatches = matches.size();
+        
+        double columnMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                matches.clear();
+                columns.select(criteria, mode, matches);
+            }
+        });
+        
+        printResult(name + " (" + to_string(rowMatches) + " rows): records", rowMs / rounds, "ms");
+        printResult(name + " (" + to_string(matches.size()) + " rows): columns", columnMs / rounds, "ms");
+        printResult(name + ": speedup", rowMs / columnMs, "x");
+    }
+    
+    // A categorical filter through the bitmaps and the records, and through the
+    // column kernels when they cover every field (they have no section column).
+    void benchBitmapFilter(const string& name, const vector<Student>& students,
+                           const StudentColumns& columns, const SearchCriteria& criteria,
+                           SearchMode mode = SearchMode::MATCH_ALL) {
+        const int rounds = 10;
+        vector<SearchField> fields = SearchManager::activeFields(criteria);
+        vector<const Student*> matches;
+        
+        double rowMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                matches.clear();
+                for (const Student& s : students) {
+                    if (SearchManager::matchesFields(s, criteria, fields, mode)) matches.push_back(&s);
+                }
+            }
+        });
+        bool columnar = all_of(fields.begin(), fields.end(), StudentColumns::isColumnar);
+        double columnMs = timeMs([&] {
+            for (int i = 0; i < rounds && columnar; ++i) {
+                matches.clear();
+                columns.select(criteria, mode, matches);
+            }
+        });
+        double bitmapMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                matches.clear();
+                columns.selectByBitmaps(criteria, mode, matches);
+            }
+        });
+        
+        printResult(name + " (" + to_string(matches.size()) + " rows): records", rowMs / rounds, "ms");
+        if (columnar) {
+            printResult(name + ": columns", columnMs / rounds, "ms");
+        }
+        printResult(name + ": bitmaps", bitmapMs / rounds, "ms");
+    }
+    
+    void runColumnBench(int count) {
+        printHeader("Column filters (" + to_string(count) + " students, "
+                    + StudentColumns::kernelName() + " kernels)");
+        vector<Student> students = makeStudents(count);
+        
+        StudentColumns columns;
+        for (const Student& s : students) columns.add(&s);
+        
+        SearchCriteria ageSexYear;
+        ageSexYear.age = 20;
+        ageSexYear.sex = 'F';
+        ageSexYear.yearOfStudy = 2;
+        benchColumnFilter("age=20 AND sex=F AND year=2", students, columns, ageSexYear);
+        
+        SearchCriteria departmentGpa;
+        departmentGpa.department = "SE";
+        departmentGpa.minGPA = 3.5;
+        benchColumnFilter("dept=SE AND GPA >= 3.5", students, columns, departmentGpa);
+        
+        SearchCriteria sex;
+        sex.sex = 'M';
+        benchColumnFilter("sex=M", students, columns, sex);
+        
+        SearchCriteria ageOrYear;
+        ageOrYear.age = 30;
+        ageOrYear.yearOfStudy = 5;
+        benchColumnFilter("age=30 OR year=5", students, columns, ageOrYear, SearchMode::MATCH_ANY);
+        
+        SearchCriteria departmentSection;
+        departmentSection.department = "SE";
+        departmentSection.section = "B";
+        benchBitmapFilter("dept=SE AND section=B", students, columns, departmentSection);
+        
+        SearchCriteria sexYear;
+        sexYear.sex = 'F';
+        sexYear.yearOfStudy = 2;
+        benchBitmapFilter("sex=F AND year=2", students, columns, sexYear);
+        
+        SearchCriteria anyOf;
+        anyOf.department = "SE";
+        anyOf.yearOfStudy = 5;
+        anyOf.sex = 'F';
+        benchBitmapFilter("dept=SE OR year=5 OR sex=F", students, columns, anyOf, SearchMode::MATCH_ANY);
+        
+        anyOf.sex = '\0';
+        anyOf.section = "A";
+        benchBitmapFilter("dept=SE OR year=5 OR section=A", students, columns, anyOf, SearchMode::MATCH_ANY);
+    }
+}
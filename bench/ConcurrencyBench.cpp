@@ -0,0 +1,92 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+namespace Bench {
+    
+    // Read throughput of a StudentManager shared by `readers` threads, each
+    // mixing ID lookups (transcript views) with logins, optionally alongside
+    // one writer updating a random student about once a millisecond.
+    template <typename Manager>
+    double measureReadThroughput(Manager& manager, const vector<Student>& sorted,
+                                 int readers, bool withWriter) {
+        const auto duration = chrono::milliseconds(300);
+        atomic<bool> running(true);
+        atomic<long long> totalReads(0);
+        
+        vector<thread> threads;
+        for (int t = 0; t < readers; ++t) {
+            threads.emplace_back([&, t] {
+                mt19937 rng(100 + t);
+                long long reads = 0;
+                double sink = 0;
+                
+                while (running.load(memory_order_relaxed)) {
+                    const string& id = sorted[rng() % sorted.size()].getId();
+                    if (reads % 10 == 0) {
+                        sink += manager.authenticate(id, "password") == Manager::UserType::STUDENT;
+                    } else {
+                        manager.withStudent(id, [&](const Student& s) { sink += s.getGPA(); });
+                    }
+                    ++reads;
+                }
+                
+                totalReads += reads;
+                if (sink < 0) cout << sink << endl;
+            });
+        }
+        
+        thread writer;
+        if (withWriter) {
+            writer = thread([&] {
+                mt19937 rng(7);
+                while (running.load(memory_order_relaxed)) {
+                    Student updated = sorted[rng() % sorted.size()];
+                    updated.setGPA((rng() % 401) / 100.0);
+                    manager.updateStudent(updated.getId(), updated, false);
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                }
+            });
+        }
+        
+        double elapsedMs = timeMs([&] {
+            this_thread::sleep_for(duration);
+            running = false;
+            for (thread& t : threads) t.join();
+            if (writer.joinable()) writer.join();
+        });
+        
+        return totalReads * 1000.0 / elapsedMs;
+    }
+    
+    void runConcurrencyBench(int count) {
+        printHeader("Concurrent readers (" + to_string(count) + " students, "
+                    + to_string(thread::hardware_concurrency()) + " hardware threads)");
+        vector<Student> sorted = makeStudents(count);
+        
+        string studentsFile = "bench_students.csv";
+        string coursesFile = "bench_courses.csv";
+        writeRosterFiles(sorted, studentsFile, coursesFile);
+        
+        {
+            StudentManager manager(studentsFile, coursesFile);
+            int maxThreads = max(2, static_cast<int>(thread::hardware_concurrency()));
+            
+            for (int readers = 1; readers <= maxThreads; readers *= 2) {
+                printResult(to_string(readers) + " reader(s)",
+                            measureReadThroughput(manager, sorted, readers, false) / 1e6, "M reads/s");
+                printResult(to_string(readers) + " reader(s) + 1 writer",
+                            measureReadThroughput(manager, sorted, readers, true) / 1e6, "M reads/s");
+            }
+        }
+        
+        remove(studentsFile.c_str());
+        remove(coursesFile.c_str());
+    }
+}
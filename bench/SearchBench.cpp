@@ -0,0 +1,301 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace Bench {
+    
+    // One query through StudentManager::searchStudents (index-assisted) and
+    // through SearchManager::search over the whole roster.
+    template <typename Manager>
+    void benchQuery(const string& name, const Manager& manager, const SearchCriteria& criteria) {
+        const int rounds = 20;
+        size_t matches = 0;
+        
+        double indexedMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) matches = manager.searchStudents(criteria).size();
+        });
+        double scanMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                matches = SearchManager::search(manager.getStudentStore(), criteria).size();
+            }
+        });
+        
+        printResult(name + " (" + to_string(matches) + " rows): indexed", indexedMs / rounds, "ms");
+        printResult(name + ": full scan", scanMs / rounds, "ms");
+        
+        stringstream plan(manager.explain(criteria));
+        string line;
+        while (getline(plan, line)) cout << "      " << line << endl;
+    }
+    
+    // A broad query fetched as copies, as handles, and as the first page of
+    // 50 handles, which stops the scan once the page is full.
+    template <typename Manager>
+    void benchPaging(const Manager& manager) {
+        const int rounds = 20;
+        SearchCriteria broad;
+        broad.department = "SE";
+        size_t matches = 0;
+        
+        double copyMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) matches = manager.searchStudents(broad).size();
+        });
+        double handleMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) matches = manager.searchHandles(broad).size();
+        });
+        double pageMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                matches = manager.searchHandles(broad, SearchMode::MATCH_ALL, 100, 50).size();
+            }
+        });
+        
+        printResult("dept=SE: copies", copyMs / rounds, "ms");
+        printResult("dept=SE: handles", handleMs / rounds, "ms");
+        printResult("dept=SE: 50 handles from offset 100", pageMs * 1000 / rounds, "us");
+    }
+    
+    // A dashboard re-running the same query, with an edit every `editEvery`
+    // queries invalidating the cached results.
+    template <typename Manager>
+    void benchQueryCache(Manager& manager, const vector<Student>& sorted) {
+        const int queries = 1000;
+        SearchCriteria dashboard;
+        dashboard.department = "SE";
+        dashboard.yearOfStudy = 3;
+        
+        manager.setQueryCacheCapacity(0);
+        double uncachedMs = timeMs([&] {
+            for (int i = 0; i < queries; ++i) manager.searchStudents(dashboard);
+        });
+        printResult("dept=SE year=3, uncached", uncachedMs / queries, "ms/query");
+        manager.setQueryCacheCapacity(100000);
+        
+        for (int editEvery : {0, 100, 10}) {
+            QueryCacheStats before = manager.getQueryCacheStats();
+            double ms = timeMs([&] {
+                for (int i = 0; i < queries; ++i) {
+                    if (editEvery > 0 && i % editEvery == 0) {
+                        Student edited = sorted[i % sorted.size()];
+                        edited.setGPA(i % 401 / 100.0);
+                        manager.updateStudent(edited.getId(), edited, false);
+                    }
+                    manager.searchStudents(dashboard);
+                }
+            });
+            QueryCacheStats after = manager.getQueryCacheStats();
+            
+            long long hits = after.hits - before.hits;
+            long long misses = after.misses - before.misses;
+            string label = editEvery > 0 ? "edit every " + to_string(editEvery) : "no edits";
+            printResult("dept=SE year=3, cached, " + label, ms / queries, "ms/query");
+            printResult("  hit rate", 100.0 * hits / max(1LL, hits + misses), "%");
+        }
+    }
+    
+    // A query in the query language through StudentManager::queryStudents
+    // (pushdown to an index where possible), and as a full scan evaluating
+    // the tree in the order written and in the optimized order.
+    template <typename Manager>
+    void benchCompiledQuery(const Manager& manager, const string& query) {
+        const int rounds = 20;
+        QueryNode written;
+        string error;
+        if (!QueryCompiler::compile(query, written, error)) {
+            cout << "  " << query << ": " << error << endl;
+            return;
+        }
+        QueryNode optimized = written;
+        QueryCompiler::optimize(optimized, manager.getStudentStore(), manager.getStudentIndex());
+        
+        size_t matches = 0;
+        double plannedMs = timeMs([&] {
+            vector<Student> results;
+            for (int i = 0; i < rounds; ++i) {
+                manager.queryStudents(query, results, error);
+                matches = results.size();
+            }
+        });
+        auto scan = [&](const QueryNode& root) {
+            return timeMs([&] {
+                for (int i = 0; i < rounds; ++i) {
+                    matches = 0;
+                    for (const Student& s : manager.getStudentStore()) matches += root.matches(s) ? 1 : 0;
+                }
+            });
+        };
+        double writtenMs = scan(written);
+        double optimizedMs = scan(optimized);
+        
+        printResult(query + " (" + to_string(matches) + " rows)", plannedMs / rounds, "ms");
+        printResult("  full scan, as written", writtenMs / rounds, "ms");
+        printResult("  full scan, reordered", optimizedMs / rounds, "ms");
+    }
+    
+    // A misspelled first name looked up through a BK-tree and by computing the
+    // edit distance to every student's name.
+    void benchFuzzyNames(int count) {
+        const int rounds = 20;
+        vector<Student> students = makeStudents(count);
+        randomizeNames(students);
+        
+        BKTree tree;
+        for (const Student& student : students) tree.add(&student, student.getFirstNameKey());
+        cout << "  " << tree.distinctNames() << " distinct first names" << endl;
+        
+        for (const string& query : vector<string>{"Fikremarim", "Abeb"}) {
+            for (int maxDistance : {1, 2}) {
+                string folded = Utils::toLower(query);
+                size_t scanned = 0;
+                double scanMs = timeMs([&] {
+                    for (int i = 0; i < rounds; ++i) {
+                        scanned = 0;
+                        for (const Student& student : students) {
+                            if (Utils::editDistance(folded, student.getFirstNameKey()) <= maxDistance) {
+                                scanned++;
+                            }
+                        }
+                    }
+                });
+                
+                size_t found = 0;
+                int compared = 0;
+                double treeMs = timeMs([&] {
+                    for (int i = 0; i < rounds; ++i) {
+                        found = 0;
+                        compared = tree.forEachWithin(query, maxDistance,
+                                                      [&](const Student*, int) { found++; });
+                    }
+                });
+                
+                string label = "'" + query + "' within " + to_string(maxDistance);
+                printResult(label + " (" + to_string(scanned) + " rows): every row", scanMs / rounds, "ms");
+                printResult(label + " (" + to_string(found) + " rows): BK-tree", treeMs / rounds, "ms");
+                printResult("  (" + to_string(compared) + " names compared)", scanMs / treeMs, "x faster");
+            }
+        }
+    }
+    
+    void runSearchBench(int count) {
+        printHeader("Search (" + to_string(count) + " students)");
+        vector<Student> sorted = makeStudents(count);
+        
+        // Start from an empty file and add the roster directly: loading from
+        // CSV recomputes GPAs from course results, which these students lack.
+        string studentsFile = "bench_students.csv";
+        string coursesFile = "bench_courses.csv";
+        writeRosterFiles({}, studentsFile, coursesFile);
+        
+        {
+            StudentManager manager(studentsFile, coursesFile);
+            for (const Student& s : sorted) manager.addStudent(s, false);
+            
+            // Time the plans themselves; the result cache is measured below.
+            manager.setQueryCacheCapacity(0);
+            
+            SearchCriteria idAndDepartment;
+            idAndDepartment.id = makeId(576);
+            idAndDepartment.department = "SE";
+            benchQuery("id=0000576 AND dept=SE", manager, idAndDepartment);
+            
+            SearchCriteria cohort;
+            cohort.department = "SE";
+            cohort.yearOfStudy = 3;
+            cohort.section = "B";
+            benchQuery("SE year 3 section B", manager, cohort);
+            
+            SearchCriteria honours;
+            honours.minGPA = 3.5;
+            honours.maxGPA = 4.0;
+            benchQuery("GPA 3.5-4.0", manager, honours);
+            
+            SearchCriteria topBand;
+            topBand.minGPA = 3.95;
+            benchQuery("GPA >= 3.95", manager, topBand);
+            
+            SearchCriteria ageSexYear;
+            ageSexYear.age = 20;
+            ageSexYear.sex = 'F';
+            ageSexYear.yearOfStudy = 2;
+            benchQuery("age=20, female, year 2", manager, ageSexYear);
+            
+            SearchCriteria byName;
+            byName.lastName = "gula";
+            benchQuery("last name contains 'gula'", manager, byName);
+            
+            SearchCriteria byFirstName;
+            byFirstName.firstName = "Fikre";
+            benchQuery("first name contains 'Fikre'", manager, byFirstName);
+            
+            SearchCriteria shortName;
+            shortName.firstName = "na";
+            benchQuery("first name contains 'na'", manager, shortName);
+            
+            SearchCriteria mixed;
+            mixed.department = "SE";
+            mixed.sex = 'F';
+            mixed.lastName = "gula";
+            benchQuery("SE, female, last name 'gula'", manager, mixed);
+            
+            benchPaging(manager);
+            
+            for (const string& query : vector<string>{"dept=SE and year=3 and gpa>=3.5",
+                                                      "first~kebe and sex=F and age>=25",
+                                                      "age>=25 and last~gula and dept!=CS and year<=2",
+                                                      "(dept=SE and year=3) or gpa>=3.9"}) {
+                benchCompiledQuery(manager, query);
+            }
+            
+            benchQueryCache(manager, sorted);
+        }
+        
+        remove(studentsFile.c_str());
+        remove(coursesFile.c_str());
+        
+        benchFuzzyNames(count);
+    }
+    
+    // Full-scan search split across 1, 2, 4, ... pool threads, over a vector
+    // (split by position) and over the AVL tree (split with select()).
+    void runParallelSearchBench(int count) {
+        printHeader("Parallel search (" + to_string(count) + " students, "
+                    + to_string(thread::hardware_concurrency()) + " hardware threads)");
+        vector<Student> sorted = makeStudents(count);
+        StudentTree tree;
+        tree.buildFrom(sorted);
+        
+        // Short substrings bypass the trigram index, so this is a full scan.
+        SearchCriteria criteria;
+        criteria.lastName = "ek";
+        criteria.minGPA = 2.0;
+        
+        const int rounds = 5;
+        size_t matches = 0;
+        double sequentialMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) matches = SearchManager::search(tree, criteria).size();
+        }) / rounds;
+        printResult("sequential (" + to_string(matches) + " rows)", sequentialMs, "ms");
+        
+        int maxThreads = max(4, static_cast<int>(thread::hardware_concurrency()));
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            ThreadPool pool(threads);
+            double vectorMs = timeMs([&] {
+                for (int i = 0; i < rounds; ++i) {
+                    matches = SearchManager::parallelSearch(sorted, criteria, SearchMode::MATCH_ALL, pool).size();
+                }
+            }) / rounds;
+            double treeMs = timeMs([&] {
+                for (int i = 0; i < rounds; ++i) {
+                    matches = SearchManager::parallelSearch(tree, criteria, SearchMode::MATCH_ALL, pool).size();
+                }
+            }) / rounds;
+            
+            printResult(to_string(threads) + " thread(s), vector", vectorMs, "ms");
+            printResult(to_string(threads) + " thread(s), AVL tree", treeMs, "ms");
+            printResult(to_string(threads) + " thread(s), AVL tree speedup", sequentialMs / treeMs, "x");
+        }
+    }
+}
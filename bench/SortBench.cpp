@@ -0,0 +1,164 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <numeric>
+
+using namespace std;
+
+namespace Bench {
+    
+    // The quicksort Sorter used before introsort: last element as pivot,
+    // Lomuto partition, recursion on both sides. Kept to show its worst case.
+    template <typename Less>
+    void lomutoQuickSort(vector<Student>& students, int low, int high, Less less) {
+        if (low >= high) return;
+        int i = low - 1;
+        for (int j = low; j < high; ++j) {
+            if (less(students[j], students[high])) swap(students[++i], students[j]);
+        }
+        swap(students[i + 1], students[high]);
+        lomutoQuickSort(students, low, i, less);
+        lomutoQuickSort(students, i + 2, high, less);
+    }
+    
+    // One field sorted from one input order: with Sorter::sort (counting or
+    // radix sort for small-domain fields, sorted keys for the rest, then each
+    // Student moved once), as a sorted view, by introsort and std::sort
+    // swapping the Students themselves, by a comparison-based stable sort of
+    // positions, and with the old quicksort when `legacy` is set.
+    void benchSortField(const string& name, const vector<Student>& input, SortField field, bool legacy) {
+        auto less = [field](const Student& a, const Student& b) { return Sorter::compare(a, b, field) < 0; };
+        
+        vector<Student> students = input;
+        double keyedMs = timeMs([&] { Sorter::sort(students, field); });
+        double viewMs = timeMs([&] { Sorter::sortedView(input, field); });
+        students = input;
+        double introMs = timeMs([&] { Sorter::introSort(students.begin(), students.end(), less); });
+        students = input;
+        double stdMs = timeMs([&] { std::sort(students.begin(), students.end(), less); });
+        vector<int> positions(input.size());
+        iota(positions.begin(), positions.end(), 0);
+        double stableMs = timeMs([&] {
+            stable_sort(positions.begin(), positions.end(), [&](int a, int b) { return less(input[a], input[b]); });
+        });
+        
+        printResult(name + ": Sorter::sort", keyedMs, "ms");
+        printResult(name + ": Sorter::sortedView", viewMs, "ms");
+        printResult(name + ": introsort on Students", introMs, "ms");
+        printResult(name + ": std::sort on Students", stdMs, "ms");
+        printResult(name + ": stable_sort of positions", stableMs, "ms");
+        if (legacy) {
+            students = input;
+            double lomutoMs = timeMs([&] {
+                lomutoQuickSort(students, 0, static_cast<int>(students.size()) - 1, less);
+            });
+            printResult(name + ": old quicksort", lomutoMs, "ms");
+        }
+    }
+    
+    // One key list sorted from one input order: by Sorter::sortedOrder (the
+    // compiled chain for listed combos, key-at-a-time passes otherwise), by
+    // sortedOrderBy<Keys...>() directly, and by a stable_sort of positions
+    // with a comparator that switches on each key's field.
+    template <typename... Keys>
+    void benchSortKeys(const string& name, const vector<Student>& input) {
+        vector<SortKey> keys = {SortKey(Keys::field, Keys::ascending)...};
+        auto less = [&keys](const Student& a, const Student& b) {
+            for (const SortKey& key : keys) {
+                int order = Sorter::compare(a, b, key.field);
+                if (order != 0) return key.ascending ? order < 0 : order > 0;
+            }
+            return false;
+        };
+        
+        double sorterMs = timeMs([&] { Sorter::sortedOrder(input, keys); });
+        double compiledMs = timeMs([&] { Sorter::sortedOrderBy<Keys...>(input); });
+        vector<int> positions(input.size());
+        iota(positions.begin(), positions.end(), 0);
+        double stableMs = timeMs([&] {
+            stable_sort(positions.begin(), positions.end(), [&](int a, int b) { return less(input[a], input[b]); });
+        });
+        
+        printResult(name + ": Sorter::sortedOrder", sorterMs, "ms");
+        printResult(name + ": sortedOrderBy<...>", compiledMs, "ms");
+        printResult(name + ": stable_sort, chained compare", stableMs, "ms");
+    }
+    
+    void runSortBench(int count) {
+        printHeader("Sort (" + to_string(count) + " students)");
+        vector<Student> sorted = makeStudents(count);
+        randomizeNames(sorted);
+        vector<Student> reversed(sorted.rbegin(), sorted.rend());
+        vector<Student> random = shuffled(sorted);
+        
+        // The old quicksort is quadratic on sorted input and on few distinct
+        // keys, so it only gets a roster small enough to finish.
+        const int legacyLimit = 5000;
+        bool legacy = count <= legacyLimit;
+        
+        benchSortField("by ID, sorted input", sorted, SortField::ID, legacy);
+        benchSortField("by ID, reversed input", reversed, SortField::ID, legacy);
+        benchSortField("by ID, random input", random, SortField::ID, legacy);
+        benchSortField("by name, random input", random, SortField::NAME, legacy);
+        benchSortField("by GPA, random input", random, SortField::GPA, legacy);
+        benchSortField("by sex (2 values)", random, SortField::SEX, legacy);
+        benchSortField("by year (5 values)", random, SortField::YEAR_OF_STUDY, legacy);
+        benchSortField("by age (14 values)", random, SortField::AGE, legacy);
+        
+        // GPAs computed from credit hours aren't whole hundredths, which
+        // takes the radix path instead of the counting one.
+        vector<Student> unrounded = random;
+        for (Student& s : unrounded) s.setGPA(s.getGPA() / 3);
+        benchSortField("by GPA, unrounded", unrounded, SortField::GPA, legacy);
+        
+        // The first two are compiled combos; the last runs key at a time.
+        typedef SortField F;
+        benchSortKeys<By<F::DEPARTMENT>, By<F::YEAR_OF_STUDY>, By<F::GPA, false>, By<F::NAME>>(
+            "dept, year, -GPA, name", random);
+        benchSortKeys<By<F::YEAR_OF_STUDY>, By<F::GPA, false>>("year, -GPA", random);
+        benchSortKeys<By<F::SEX>, By<F::AGE, false>, By<F::NAME>>("sex, -age, name", random);
+        
+        if (!legacy) {
+            vector<Student> small(random.begin(), random.begin() + legacyLimit);
+            vector<Student> smallSorted(sorted.begin(), sorted.begin() + legacyLimit);
+            cout << "  (" << legacyLimit << " students)" << endl;
+            benchSortField("by ID, sorted input", smallSorted, SortField::ID, true);
+            benchSortField("by sex (2 values)", small, SortField::SEX, true);
+            benchSortField("by GPA, random input", small, SortField::GPA, true);
+        }
+    }
+    
+    // Sorter::sort and sortedOrder on 1, 2, 4, ... threads (setThreadCount).
+    void runParallelSortBench(int count) {
+        printHeader("Parallel sort (" + to_string(count) + " students, "
+                    + to_string(thread::hardware_concurrency()) + " hardware threads)");
+        vector<Student> sorted = makeStudents(count);
+        randomizeNames(sorted);
+        vector<Student> random = shuffled(sorted);
+        
+        typedef SortField F;
+        vector<SortKey> multiKey = {F::DEPARTMENT, F::YEAR_OF_STUDY, {F::GPA, false}, F::NAME};
+        int maxThreads = max(4, static_cast<int>(thread::hardware_concurrency()));
+        double baseline[3] = {0, 0, 0};
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            Sorter::setThreadCount(threads);
+            vector<Student> students = random;
+            double times[3] = {
+                timeMs([&] { Sorter::sort(students, F::ID); }),
+                timeMs([&] { Sorter::sortedOrder(random, F::NAME); }),
+                timeMs([&] { Sorter::sortedOrder(random, multiKey); })
+            };
+            if (threads == 1) {
+                copy(begin(times), end(times), begin(baseline));
+            }
+            
+            string prefix = to_string(threads) + " thread(s), ";
+            printResult(prefix + "sort by ID", times[0], "ms");
+            printResult(prefix + "order by name", times[1], "ms");
+            printResult(prefix + "dept, year, -GPA, name", times[2], "ms");
+            printResult(prefix + "dept, year, -GPA, name speedup", baseline[2] / times[2], "x");
+        }
+        Sorter::setThreadCount(1);
+    }
+}
@@ -0,0 +1,91 @@
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace std;
+
+namespace Bench {
+    
+    // Lookup, insert, delete and full scan for one primary-store type.
+    template <typename Store>
+    void benchStore(const string& name, const vector<Student>& sorted,
+                    const vector<Student>& randomOrder) {
+        const int lookups = 1000000;
+        double sink = 0;
+        
+        mt19937 rng(3);
+        vector<string> probes;
+        probes.reserve(lookups);
+        for (int i = 0; i < lookups; ++i) {
+            probes.push_back(sorted[rng() % sorted.size()].getId());
+        }
+        
+        Store store;
+        double insertMs = timeMs([&] { for (const Student& s : randomOrder) store.insert(s); });
+        printResult(name + ": insert (random order)", insertMs * 1e6 / randomOrder.size(), "ns/op");
+        
+        double lookupMs = timeMs([&] {
+            for (const string& id : probes) {
+                const Student* found = store.find(id);
+                if (found) sink += found->getAge();
+            }
+        });
+        printResult(name + ": lookup by ID", lookupMs * 1e6 / lookups, "ns/op");
+        
+        double scanMs = timeMs([&] {
+            for (const Student& s : store) sink += s.getGPA();
+        });
+        printResult(name + ": full in-order scan", scanMs * 1e6 / store.size(), "ns/row");
+        
+        size_t removed = randomOrder.size() / 2;
+        double removeMs = timeMs([&] {
+            for (size_t i = 0; i < removed; ++i) store.remove(randomOrder[i].getId());
+        });
+        printResult(name + ": delete (random order)", removeMs * 1e6 / removed, "ns/op");
+        
+        if (sink < 0) cout << sink << endl;
+    }
+    
+    // Cost of taking a read-only copy of the roster: a rebuilt AVL tree versus
+    // sharing the persistent tree's root.
+    void benchSnapshot(const vector<Student>& sorted) {
+        const int rounds = 10;
+        
+        StudentTree tree;
+        tree.buildFrom(sorted);
+        StudentPersistentTree persistent;
+        persistent.buildFrom(sorted);
+        
+        int sink = 0;
+        double copyMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                StudentPersistentTree copy;
+                copy.buildFrom(tree.getAll());
+                sink += copy.size();
+            }
+        });
+        printResult("snapshot: rebuild from AVLTree", copyMs / rounds, "ms");
+        
+        double shareMs = timeMs([&] {
+            for (int i = 0; i < rounds; ++i) sink += persistent.snapshot().size();
+        });
+        printResult("snapshot: PersistentAVLTree", shareMs * 1e6 / rounds, "ns");
+        
+        if (sink < 0) cout << sink << endl;
+    }
+    
+    void runStoreBench(int count) {
+        vector<int> sizes = count > 0 ? vector<int>{count} : vector<int>{10000, 100000, 1000000};
+        
+        for (int n : sizes) {
+            printHeader("Primary store comparison (" + to_string(n) + " students)");
+            vector<Student> sorted = makeStudents(n);
+            vector<Student> randomOrder = shuffled(sorted);
+            
+            benchStore<StudentTree>("AVLTree", sorted, randomOrder);
+            benchStore<StudentBlockStore>("BlockedSortedArray", sorted, randomOrder);
+            benchStore<StudentPersistentTree>("PersistentAVLTree", sorted, randomOrder);
+            benchSnapshot(sorted);
+        }
+    }
+}
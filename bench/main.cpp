@@ -0,0 +1,82 @@
+using namespace std;
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "../src/Utils.cpp"
+#include "../src/Course.cpp"
+#include "../src/PoolAllocator.cpp"
+#include "../src/AVLTree.cpp"
+#include "../src/BlockedSortedArray.cpp"
+#include "../src/PersistentAVLTree.cpp"
+#include "../src/Student.cpp"
+#include "../src/UndoManager.cpp"
+#include "../src/ThreadPool.cpp"
+#include "../src/Sorter.cpp"
+#include "../src/SearchManager.cpp"
+#include "../src/TrigramIndex.cpp"
+#include "../src/BKTree.cpp"
+#include "../src/RadixTrie.cpp"
+#include "../src/RowBitmap.cpp"
+#include "../src/StudentColumns.cpp"
+#include "../src/StudentIndex.cpp"
+#include "../src/QueryPlanner.cpp"
+#include "../src/QueryCompiler.cpp"
+#include "../src/QueryCache.cpp"
+#include "../src/StudentManager.cpp"
+
+#include "BenchUtils.cpp"
+#include "AVLTreeBench.cpp"
+#include "StoreBench.cpp"
+#include "SearchBench.cpp"
+#include "ColumnBench.cpp"
+#include "ConcurrencyBench.cpp"
+#include "AutocompleteBench.cpp"
+#include "SortBench.cpp"
+
+// Usage: ./student_bench [suite] [student count]
+// Suites: avl, store, search, parallel, columns, concurrency, autocomplete, sort, parallelsort, all (default). Without a count each suite uses its
+// own default roster sizes.
+int main(int argc, char* argv[]) {
+    string suite = argc > 1 ? argv[1] : "all";
+    int count = argc > 2 ? atoi(argv[2]) : 0;
+    
+    if (suite == "avl" || suite == "all") {
+        Bench::runAVLTreeBench(count > 0 ? count : 100000);
+    }
+    
+    if (suite == "store" || suite == "all") {
+        Bench::runStoreBench(count);
+    }
+    
+    if (suite == "search" || suite == "all") {
+        Bench::runSearchBench(count > 0 ? count : 100000);
+    }
+    
+    if (suite == "parallel" || suite == "all") {
+        Bench::runParallelSearchBench(count > 0 ? count : 1000000);
+    }
+    
+    if (suite == "columns" || suite == "all") {
+        Bench::runColumnBench(count > 0 ? count : 1000000);
+    }
+    
+    if (suite == "concurrency" || suite == "all") {
+        Bench::runConcurrencyBench(count > 0 ? count : 100000);
+    }
+    
+    if (suite == "autocomplete" || suite == "all") {
+        Bench::runAutocompleteBench(count > 0 ? count : 1000000);
+    }
+    
+    if (suite == "sort" || suite == "all") {
+        Bench::runSortBench(count > 0 ? count : 100000);
+    }
+    
+    if (suite == "parallelsort" || suite == "all") {
+        Bench::runParallelSortBench(count > 0 ? count : 1000000);
+    }
+    
+    return 0;
+}
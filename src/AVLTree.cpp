@@ -1,38 +1,138 @@
 #include <algorithm>
 #include <vector>
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <string_view>
 
 using namespace std;
 
-template <typename T>
+// Default key extractor: the element is its own key.
+struct IdentityKey {
+    template <typename U>
+    const U& operator()(const U& value) const { return value; }
+};
+
+// Puts `values` into strictly increasing key order for the bulk builders.
+// Already-sorted input is detected in one pass and left alone; otherwise
+// positions are sorted rather than the elements themselves, so each element is
+// moved once, and the last of any run of equal keys is kept.
+template <typename T, typename KeyLess>
+void sortUniqueByKey(vector<T>& values, KeyLess keyLess) {
+    bool strictlySorted = true;
+    for (size_t i = 1; i < values.size() && strictlySorted; ++i) {
+        strictlySorted = keyLess(values[i - 1], values[i]);
+    }
+    
+    if (strictlySorted) {
+        return;
+    }
+    
+    vector<size_t> order(values.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return keyLess(values[a], values[b]);
+    });
+    
+    vector<T> sortedValues;
+    sortedValues.reserve(values.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        bool duplicateFollows = i + 1 < order.size() &&
+                                !keyLess(values[order[i]], values[order[i + 1]]);
+        if (!duplicateFollows) {
+            sortedValues.push_back(move(values[order[i]]));
+        }
+    }
+    values.swap(sortedValues);
+}
+
+// Runs a forEach visitor on one element. Visitors may return void, or bool
+// where false asks the container to stop the walk.
+template <typename Visitor, typename T>
+bool visitElement(Visitor& visit, const T& value) {
+    if constexpr (is_same<invoke_result_t<Visitor&, const T&>, bool>::value) {
+        return visit(value);
+    } else {
+        visit(value);
+        return true;
+    }
+}
+
+// KeyOf maps an element to the key it is ordered by, and Compare orders keys.
+// With a transparent Compare (the default less<>) lookups accept anything
+// comparable with the key, e.g. a string_view ID instead of a whole Student.
+template <typename T, typename KeyOf = IdentityKey, typename Compare = less<>,
+          template <typename> class NodeAllocator = PoolAllocator>
 class AVLTree {
 private:
     struct Node {
         T data;
         Node* left;
         Node* right;
+        Node* parent;
         int height;
+        int size;   // number of nodes in this subtree
         
-        Node(const T& value) : data(value), left(nullptr), right(nullptr), height(1) {}
+        template <typename U>
+        Node(U&& value) : data(forward<U>(value)), left(nullptr), right(nullptr),
+                          parent(nullptr), height(1), size(1) {}
     };
     
     Node* root;
+    NodeAllocator<Node> allocator;
+    KeyOf keyOf;
+    Compare comp;
+    
+    // Lookups may pass either an element or a bare key.
+    template <typename K>
+    decltype(auto) keyFor(const K& value) const {
+        if constexpr (is_same<K, T>::value) {
+            return keyOf(value);
+        } else {
+            return (value);
+        }
+    }
     
-
     int getHeight(Node* node) const {
         return node ? node->height : 0;
     }
     
+    int getSize(Node* node) const {
+        return node ? node->size : 0;
+    }
+    
     int getBalance(Node* node) const {
         return node ? getHeight(node->left) - getHeight(node->right) : 0;
     }
     
-    void updateHeight(Node* node) {
+    void updateNode(Node* node) {
         if (node) {
             node->height = 1 + max(getHeight(node->left), getHeight(node->right));
+            node->size = 1 + getSize(node->left) + getSize(node->right);
         }
     }
     
+    // Points `parent` (or the root) at `newChild` where it used to hold `oldChild`.
+    void replaceChild(Node* parent, Node* oldChild, Node* newChild) {
+        if (!parent) {
+            root = newChild;
+        } else if (parent->left == oldChild) {
+            parent->left = newChild;
+        } else {
+            parent->right = newChild;
+        }
+        
+        if (newChild) {
+            newChild->parent = parent;
+        }
+    }
+    
+    // Rotations return the new subtree root; its parent pointer is already set,
+    // the caller re-attaches it to that parent.
     Node* rotateRight(Node* y) {
         Node* x = y->left;
         Node* T2 = x->right;
@@ -40,8 +140,12 @@ private:
         x->right = y;
         y->left = T2;
         
-        updateHeight(y);
-        updateHeight(x);
+        x->parent = y->parent;
+        y->parent = x;
+        if (T2) T2->parent = y;
+        
+        updateNode(y);
+        updateNode(x);
         
         return x;
     }
@@ -53,14 +157,18 @@ private:
         y->left = x;
         x->right = T2;
         
-        updateHeight(x);
-        updateHeight(y);
+        y->parent = x->parent;
+        x->parent = y;
+        if (T2) T2->parent = x;
+        
+        updateNode(x);
+        updateNode(y);
         
         return y;
     }
     
     Node* balance(Node* node) {
-        updateHeight(node);
+        updateNode(node);
         int balanceFactor = getBalance(node);
         
         // Left-Left case
@@ -88,22 +196,54 @@ private:
         return node;
     }
     
-    Node* insertNode(Node* node, const T& value) {
-        if (!node) {
-            return new Node(value);
+    // Walks from `node` up to the root, restoring heights, sizes and balance.
+    void rebalanceFrom(Node* node) {
+        while (node) {
+            Node* parent = node->parent;
+            Node* subtree = balance(node);
+            if (subtree != node) {
+                replaceChild(parent, node, subtree);
+            }
+            node = parent;
         }
+    }
+    
+    template <typename U>
+    Node* insertNode(U&& value) {
+        Node* parent = nullptr;
+        Node* node = root;
+        bool goLeft = false;
         
-        if (value < node->data) {
-            node->left = insertNode(node->left, value);
-        } else if (value > node->data) {
-            node->right = insertNode(node->right, value);
+        {
+            const auto& key = keyOf(value);
+            while (node) {
+                parent = node;
+                if (comp(key, keyOf(node->data))) {
+                    node = node->left;
+                    goLeft = true;
+                } else if (comp(keyOf(node->data), key)) {
+                    node = node->right;
+                    goLeft = false;
+                } else {
+                    // Duplicate - update the data
+                    node->data = forward<U>(value);
+                    return node;
+                }
+            }
+        }
+        
+        Node* created = allocator.create(forward<U>(value));
+        created->parent = parent;
+        if (!parent) {
+            root = created;
+        } else if (goLeft) {
+            parent->left = created;
         } else {
-            // Duplicate - update the data
-            node->data = value;
-            return node;
+            parent->right = created;
         }
         
-        return balance(node);
+        rebalanceFrom(parent);
+        return created;
     }
     
     Node* findMin(Node* node) const {
@@ -113,101 +253,325 @@ private:
         return node;
     }
     
-    Node* removeNode(Node* node, const T& value) {
-        if (!node) {
-            return nullptr;
-        }
+    // Unlinks the node rather than copying its successor's data over it, so
+    // pointers to the remaining elements stay valid.
+    void removeNode(Node* node) {
+        Node* rebalanceStart;
         
-        if (value < node->data) {
-            node->left = removeNode(node->left, value);
-        } else if (value > node->data) {
-            node->right = removeNode(node->right, value);
-        } else {
-            if (!node->left || !node->right) {
-                Node* temp = node->left ? node->left : node->right;
-                
-                if (!temp) {
-                    temp = node;
-                    node = nullptr;
-                } else {
-                    *node = *temp;
-                }
-                
-                delete temp;
+        if (node->left && node->right) {
+            Node* successor = findMin(node->right);
+            
+            if (successor->parent != node) {
+                rebalanceStart = successor->parent;
+                replaceChild(successor->parent, successor, successor->right);
+                successor->right = node->right;
+                successor->right->parent = successor;
             } else {
-                Node* temp = findMin(node->right);
-                node->data = temp->data;
-                node->right = removeNode(node->right, temp->data);
+                rebalanceStart = successor;
             }
+            
+            successor->left = node->left;
+            successor->left->parent = successor;
+            replaceChild(node->parent, node, successor);
+        } else {
+            rebalanceStart = node->parent;
+            replaceChild(node->parent, node, node->left ? node->left : node->right);
         }
         
-        if (!node) {
-            return nullptr;
+        allocator.destroy(node);
+        rebalanceFrom(rebalanceStart);
+    }
+    
+    template <typename K>
+    Node* searchNode(const K& key) const {
+        Node* node = root;
+        while (node) {
+            if (comp(key, keyOf(node->data))) {
+                node = node->left;
+            } else if (comp(keyOf(node->data), key)) {
+                node = node->right;
+            } else {
+                return node;
+            }
         }
-        
-        return balance(node);
+        return nullptr;
     }
     
-    Node* searchNode(Node* node, const T& value) const {
-        if (!node || node->data == value) {
-            return node;
+    static const Node* leftmost(const Node* node) {
+        while (node && node->left) {
+            node = node->left;
         }
-        
-        if (value < node->data) {
-            return searchNode(node->left, value);
-        } else {
-            return searchNode(node->right, value);
+        return node;
+    }
+    
+    static const Node* rightmost(const Node* node) {
+        while (node && node->right) {
+            node = node->right;
         }
+        return node;
     }
     
-    void inorderTraversal(Node* node, vector<T>& result) const {
-        if (node) {
-            inorderTraversal(node->left, result);
-            result.push_back(node->data);
-            inorderTraversal(node->right, result);
+    // In-order neighbours, found through parent links so iteration needs no stack.
+    static const Node* nextNode(const Node* node) {
+        if (node->right) {
+            return leftmost(node->right);
+        }
+        const Node* parent = node->parent;
+        while (parent && node == parent->right) {
+            node = parent;
+            parent = parent->parent;
         }
+        return parent;
+    }
+    
+    static const Node* prevNode(const Node* node) {
+        if (node->left) {
+            return rightmost(node->left);
+        }
+        const Node* parent = node->parent;
+        while (parent && node == parent->left) {
+            node = parent;
+            parent = parent->parent;
+        }
+        return parent;
+    }
+    
+    // First node whose key is not less than (or, with `strict`, greater than) `key`.
+    template <typename K>
+    const Node* boundNode(const K& key, bool strict) const {
+        const Node* result = nullptr;
+        const Node* node = root;
+        while (node) {
+            bool goLeft = strict ? comp(key, keyOf(node->data))
+                                 : !comp(keyOf(node->data), key);
+            if (goLeft) {
+                result = node;
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        return result;
     }
     
+    // Builds a perfectly balanced subtree from values[first, last) and returns
+    // its root. Nodes are created middle-first, so parents sit just before
+    // their children in the pool.
+    Node* buildBalanced(vector<T>& values, int first, int last, Node* parent) {
+        if (first >= last) {
+            return nullptr;
+        }
+        
+        int middle = first + (last - first) / 2;
+        Node* node = allocator.create(move(values[middle]));
+        node->parent = parent;
+        node->left = buildBalanced(values, first, middle, node);
+        node->right = buildBalanced(values, middle + 1, last, node);
+        updateNode(node);
+        
+        return node;
+    }
+    
+    // Tears the tree down without recursion: left children are rotated up
+    // until the current node has none, at which point it can be destroyed and
+    // its right subtree processed the same way.
     void destroyTree(Node* node) {
-        if (node) {
-            destroyTree(node->left);
-            destroyTree(node->right);
-            delete node;
+        while (node) {
+            if (node->left) {
+                Node* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            } else {
+                Node* right = node->right;
+                allocator.destroy(node);
+                node = right;
+            }
         }
     }
 
 public:
+    // Read-only bidirectional iterator in key order. Stays valid until the
+    // element it points at is removed.
+    class const_iterator {
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        
+        const_iterator() : node(nullptr), tree(nullptr) {}
+        
+        reference operator*() const { return node->data; }
+        pointer operator->() const { return &(node->data); }
+        
+        const_iterator& operator++() {
+            node = nextNode(node);
+            return *this;
+        }
+        
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++(*this);
+            return old;
+        }
+        
+        const_iterator& operator--() {
+            node = node ? prevNode(node) : rightmost(tree->root);
+            return *this;
+        }
+        
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --(*this);
+            return old;
+        }
+        
+        bool operator==(const const_iterator& other) const { return node == other.node; }
+        bool operator!=(const const_iterator& other) const { return node != other.node; }
+        
+    private:
+        friend class AVLTree;
+        
+        const_iterator(const Node* n, const AVLTree* t) : node(n), tree(t) {}
+        
+        const Node* node;
+        const AVLTree* tree;
+    };
+    
+    using iterator = const_iterator;
+    
     AVLTree() : root(nullptr) {}
     
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+    
     ~AVLTree() {
-        destroyTree(root);
+        clear();
+    }
+    
+    // Pooled nodes only need their destructors run; the slabs themselves are
+    // released in one go.
+    void clear() {
+        if (!NodeAllocator<Node>::releasesInBulk || !is_trivially_destructible<T>::value) {
+            destroyTree(root);
+        }
+        allocator.clear();
+        root = nullptr;
+    }
+    
+    // Replaces the contents with `values` in O(n) when they are already in
+    // strictly increasing key order (as the CSV file is written). Otherwise the
+    // values are sorted first and, as with insert(), the last of any duplicate
+    // keys wins.
+    void buildFrom(vector<T> values) {
+        sortUniqueByKey(values, [this](const T& a, const T& b) {
+            return comp(keyOf(a), keyOf(b));
+        });
+        
+        clear();
+        root = buildBalanced(values, 0, values.size(), nullptr);
     }
     
     void insert(const T& value) {
-        root = insertNode(root, value);
+        insertNode(value);
+    }
+    
+    void insert(T&& value) {
+        insertNode(move(value));
     }
     
-    void remove(const T& value) {
-        root = removeNode(root, value);
+    // Accepts an element or a key; returns whether anything was removed.
+    template <typename K>
+    bool remove(const K& key) {
+        Node* node = searchNode(keyFor(key));
+        if (!node) {
+            return false;
+        }
+        removeNode(node);
+        return true;
     }
     
-    bool search(const T& value) const {
-        return searchNode(root, value) != nullptr;
+    template <typename K>
+    bool search(const K& key) const {
+        return searchNode(keyFor(key)) != nullptr;
     }
     
-    T* find(const T& value) {
-        Node* node = searchNode(root, value);
+    template <typename K>
+    T* find(const K& key) {
+        Node* node = searchNode(keyFor(key));
         return node ? &(node->data) : nullptr;
     }
     
-    const T* find(const T& value) const {
-        Node* node = searchNode(root, value);
+    template <typename K>
+    const T* find(const K& key) const {
+        Node* node = searchNode(keyFor(key));
         return node ? &(node->data) : nullptr;
     }
     
+    const_iterator begin() const {
+        return const_iterator(leftmost(root), this);
+    }
+    
+    const_iterator end() const {
+        return const_iterator(nullptr, this);
+    }
+    
+    template <typename K>
+    const_iterator lower_bound(const K& key) const {
+        return const_iterator(boundNode(keyFor(key), false), this);
+    }
+    
+    template <typename K>
+    const_iterator upper_bound(const K& key) const {
+        return const_iterator(boundNode(keyFor(key), true), this);
+    }
+    
+    // Calls visit(const T&) on every element in key order. If the visitor
+    // returns bool, returning false stops the walk early.
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const Node* node = leftmost(root); node; node = nextNode(node)) {
+            if (!visitElement(visit, node->data)) {
+                return;
+            }
+        }
+    }
+    
+    // Visits elements with low <= key <= high in key order. Subtrees outside
+    // the range are never entered, so the cost is O(log n + k).
+    template <typename K1, typename K2, typename Visitor>
+    void forEachInRange(const K1& low, const K2& high, Visitor&& visit) const {
+        const auto& highKey = keyFor(high);
+        for (const Node* node = boundNode(keyFor(low), false);
+             node && !comp(highKey, keyOf(node->data)); node = nextNode(node)) {
+            if (!visitElement(visit, node->data)) {
+                return;
+            }
+        }
+    }
+    
+    // For string-keyed trees: visits elements whose key starts with `prefix`.
+    // They form one contiguous run starting at lower_bound(prefix).
+    template <typename Visitor>
+    void forEachWithPrefix(string_view prefix, Visitor&& visit) const {
+        for (const Node* node = boundNode(prefix, false); node; node = nextNode(node)) {
+            string_view key = keyOf(node->data);
+            if (key.substr(0, prefix.size()) != prefix) {
+                return;
+            }
+            if (!visitElement(visit, node->data)) {
+                return;
+            }
+        }
+    }
+    
+    // Deep copy of the whole tree; prefer iterating or forEach() for reads.
     vector<T> getAll() const {
         vector<T> result;
-        inorderTraversal(root, result);
+        result.reserve(size());
+        result.assign(begin(), end());
         return result;
     }
     
@@ -216,6 +580,40 @@ public:
     }
     
     int size() const {
-        return getAll().size();
+        return getSize(root);
+    }
+    
+    // Number of elements whose key is strictly less than `key`.
+    template <typename K>
+    int rank(const K& key) const {
+        const auto& target = keyFor(key);
+        int result = 0;
+        Node* node = root;
+        while (node) {
+            if (comp(keyOf(node->data), target)) {
+                result += getSize(node->left) + 1;
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return result;
+    }
+    
+    // The k-th smallest element (0-based), or nullptr if k is out of range.
+    const T* select(int k) const {
+        Node* node = root;
+        while (node) {
+            int leftSize = getSize(node->left);
+            if (k < leftSize) {
+                node = node->left;
+            } else if (k == leftSize) {
+                return &(node->data);
+            } else {
+                k -= leftSize + 1;
+                node = node->right;
+            }
+        }
+        return nullptr;
     }
 };
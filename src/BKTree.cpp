@@ -0,0 +1,178 @@
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+using namespace std;
+
+// Burkhard-Keller tree over the distinct values of one case-folded text field
+// (a first or last name), for typo-tolerant lookups. Each child hangs off its
+// parent under their edit distance, so by the triangle inequality a query
+// within k edits of some name in a subtree can only be found under edge
+// labels in [d - k, d + k], where d is the query's distance to the parent.
+// A search therefore computes Levenshtein distances against a small part of
+// the distinct names instead of every record.
+//
+// Each node keeps the records carrying its name, sorted by address. Nodes
+// whose records are all removed stay behind to route searches and are
+// reused when the name comes back; the tree is rebuilt once they outnumber
+// the live names.
+class BKTree {
+private:
+    struct Node {
+        string name;
+        vector<const Student*> students;
+        vector<pair<int, int>> children;    // (edit distance, node), sorted by distance
+        
+        explicit Node(const string& n) : name(n) {}
+    };
+    
+    vector<Node> nodes;                     // nodes[0] is the root
+    unordered_map<string, int> nodeOf;
+    size_t liveNames;
+    
+    int insertName(const string& foldedName);
+    void rebuild();
+
+public:
+    BKTree() : liveNames(0) {}
+    
+    void add(const Student* student, const string& foldedName);
+    
+    // Bulk loading, as in TrigramIndex: append() leaves each name's records
+    // unsorted and sortAppended() sorts them once afterwards.
+    void append(const Student* student, const string& foldedName);
+    void sortAppended();
+    void remove(const Student* student, const string& foldedName);
+    void clear();
+    
+    size_t distinctNames() const { return liveNames; }
+    
+    // Calls visit(const Student*, int distance) for every record whose name is
+    // within maxDistance edits of `query` (case-insensitive), in no particular
+    // order. Returns the number of names the query was compared against.
+    template <typename Visitor>
+    int forEachWithin(const string& query, int maxDistance, Visitor visit) const;
+};
+
+
+int BKTree::insertName(const string& foldedName) {
+    auto found = nodeOf.find(foldedName);
+    if (found != nodeOf.end()) {
+        return found->second;
+    }
+    
+    int index = nodes.size();
+    if (!nodes.empty()) {
+        int parent = 0;
+        while (true) {
+            int distance = Utils::editDistance(foldedName, nodes[parent].name);
+            vector<pair<int, int>>& children = nodes[parent].children;
+            auto edge = lower_bound(children.begin(), children.end(), make_pair(distance, 0));
+            if (edge == children.end() || edge->first != distance) {
+                children.insert(edge, make_pair(distance, index));
+                break;
+            }
+            parent = edge->second;
+        }
+    }
+    
+    nodes.emplace_back(foldedName);
+    nodeOf[foldedName] = index;
+    return index;
+}
+
+void BKTree::rebuild() {
+    vector<Node> old;
+    old.swap(nodes);
+    nodeOf.clear();
+    
+    for (Node& node : old) {
+        if (!node.students.empty()) {
+            int index = insertName(node.name);
+            nodes[index].students = move(node.students);
+        }
+    }
+}
+
+void BKTree::add(const Student* student, const string& foldedName) {
+    vector<const Student*>& students = nodes[insertName(foldedName)].students;
+    if (students.empty()) {
+        liveNames++;
+    }
+    students.insert(lower_bound(students.begin(), students.end(), student, less<const Student*>()),
+                    student);
+}
+
+void BKTree::append(const Student* student, const string& foldedName) {
+    vector<const Student*>& students = nodes[insertName(foldedName)].students;
+    if (students.empty()) {
+        liveNames++;
+    }
+    students.push_back(student);
+}
+
+void BKTree::sortAppended() {
+    for (Node& node : nodes) {
+        sort(node.students.begin(), node.students.end(), less<const Student*>());
+    }
+}
+
+void BKTree::remove(const Student* student, const string& foldedName) {
+    auto found = nodeOf.find(foldedName);
+    if (found == nodeOf.end()) {
+        return;
+    }
+    
+    vector<const Student*>& students = nodes[found->second].students;
+    auto pos = lower_bound(students.begin(), students.end(), student, less<const Student*>());
+    if (pos == students.end() || *pos != student) {
+        return;
+    }
+    
+    students.erase(pos);
+    if (students.empty() && --liveNames < nodes.size() / 2) {
+        rebuild();
+    }
+}
+
+void BKTree::clear() {
+    nodes.clear();
+    nodeOf.clear();
+    liveNames = 0;
+}
+
+template <typename Visitor>
+int BKTree::forEachWithin(const string& query, int maxDistance, Visitor visit) const {
+    if (nodes.empty() || maxDistance < 0) {
+        return 0;
+    }
+    
+    string folded = Utils::toLower(query);
+    int compared = 0;
+    vector<int> pending(1, 0);
+    
+    while (!pending.empty()) {
+        const Node& node = nodes[pending.back()];
+        pending.pop_back();
+        
+        int distance = Utils::editDistance(folded, node.name);
+        compared++;
+        if (distance <= maxDistance) {
+            for (const Student* student : node.students) {
+                visit(student, distance);
+            }
+        }
+        
+        auto first = lower_bound(node.children.begin(), node.children.end(),
+                                 make_pair(distance - maxDistance, 0));
+        for (auto edge = first; edge != node.children.end() && edge->first <= distance + maxDistance;
+             ++edge) {
+            pending.push_back(edge->second);
+        }
+    }
+    
+    return compared;
+}
@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+using namespace std;
+
+// Cache-friendly alternative to AVLTree with the same interface. Keys live in
+// sorted blocks of a few hundred contiguous entries, and a flat array of each
+// block's first key sits on top, so a lookup is two binary searches over
+// contiguous memory instead of a pointer chase per tree level. Elements
+// themselves are pooled out of line: the blocks only shuffle (key, pointer)
+// pairs, and pointers to elements stay valid until the element is removed.
+// Iterators, unlike AVLTree's, are invalidated by any insert or remove.
+template <typename T, typename KeyOf = IdentityKey, typename Compare = less<>,
+          template <typename> class NodeAllocator = PoolAllocator>
+class BlockedSortedArray {
+private:
+    using RawKey = decay_t<invoke_result_t<KeyOf, const T&>>;
+    // Keys are copied into the blocks; a string_view key is stored as a string.
+    using StoredKey = conditional_t<is_same<RawKey, string_view>::value, string, RawKey>;
+    
+    struct Entry {
+        StoredKey key;
+        T* value;
+    };
+    
+    using Block = vector<Entry>;
+    
+    static constexpr size_t BLOCK_SIZE = 128;
+    static constexpr size_t MAX_BLOCK_SIZE = 2 * BLOCK_SIZE;
+    static constexpr size_t MIN_BLOCK_SIZE = BLOCK_SIZE / 4;
+    
+    vector<Block> blocks;
+    vector<StoredKey> firstKeys;    // firstKeys[b] is the smallest key in blocks[b]
+    vector<int> blockCounts;        // Fenwick tree over block sizes, for rank/select
+    int count;
+    NodeAllocator<T> allocator;
+    KeyOf keyOf;
+    Compare comp;
+    
+    template <typename K>
+    decltype(auto) keyFor(const K& value) const {
+        if constexpr (is_same<K, T>::value) {
+            return keyOf(value);
+        } else {
+            return (value);
+        }
+    }
+    
+    // Last block whose first key is <= key (block 0 if the key precedes all).
+    template <typename K>
+    size_t locateBlock(const K& key) const {
+        auto it = std::upper_bound(firstKeys.begin(), firstKeys.end(), key,
+                                   [this](const K& k, const StoredKey& first) { return comp(k, first); });
+        return it == firstKeys.begin() ? 0 : (it - firstKeys.begin()) - 1;
+    }
+    
+    template <typename K>
+    size_t lowerPosition(const Block& block, const K& key) const {
+        return std::lower_bound(block.begin(), block.end(), key,
+                                [this](const Entry& e, const K& k) { return comp(e.key, k); }) - block.begin();
+    }
+    
+    template <typename K>
+    size_t upperPosition(const Block& block, const K& key) const {
+        return std::upper_bound(block.begin(), block.end(), key,
+                                [this](const K& k, const Entry& e) { return comp(k, e.key); }) - block.begin();
+    }
+    
+    template <typename K>
+    T* findValue(const K& key) const {
+        if (blocks.empty()) {
+            return nullptr;
+        }
+        const Block& block = blocks[locateBlock(key)];
+        size_t pos = lowerPosition(block, key);
+        if (pos < block.size() && !comp(key, block[pos].key)) {
+            return block[pos].value;
+        }
+        return nullptr;
+    }
+    
+    void rebuildCounts() {
+        blockCounts.assign(blocks.size() + 1, 0);
+        for (size_t i = 1; i < blockCounts.size(); ++i) {
+            blockCounts[i] += blocks[i - 1].size();
+            size_t parent = i + (i & (~i + 1));
+            if (parent < blockCounts.size()) {
+                blockCounts[parent] += blockCounts[i];
+            }
+        }
+    }
+    
+    void addToCount(size_t blockIndex, int delta) {
+        for (size_t i = blockIndex + 1; i < blockCounts.size(); i += i & (~i + 1)) {
+            blockCounts[i] += delta;
+        }
+    }
+    
+    // Number of elements in blocks [0, blockIndex).
+    int countBefore(size_t blockIndex) const {
+        int sum = 0;
+        for (size_t i = blockIndex; i > 0; i -= i & (~i + 1)) {
+            sum += blockCounts[i];
+        }
+        return sum;
+    }
+    
+    Block makeBlock() const {
+        Block block;
+        block.reserve(MAX_BLOCK_SIZE + 1);
+        return block;
+    }
+    
+    void splitBlock(size_t b) {
+        Block tail = makeBlock();
+        size_t half = blocks[b].size() / 2;
+        move(blocks[b].begin() + half, blocks[b].end(), back_inserter(tail));
+        blocks[b].erase(blocks[b].begin() + half, blocks[b].end());
+        
+        firstKeys.insert(firstKeys.begin() + b + 1, tail.front().key);
+        blocks.insert(blocks.begin() + b + 1, move(tail));
+        rebuildCounts();
+    }
+    
+    // Folds an underfull block into a neighbour when the result still fits;
+    // returns false if neither neighbour has room.
+    bool mergeBlock(size_t b) {
+        size_t target;
+        size_t source;
+        if (b + 1 < blocks.size() && blocks[b].size() + blocks[b + 1].size() <= MAX_BLOCK_SIZE) {
+            target = b;
+            source = b + 1;
+        } else if (b > 0 && blocks[b - 1].size() + blocks[b].size() <= MAX_BLOCK_SIZE) {
+            target = b - 1;
+            source = b;
+        } else {
+            return false;
+        }
+        
+        move(blocks[source].begin(), blocks[source].end(), back_inserter(blocks[target]));
+        blocks.erase(blocks.begin() + source);
+        firstKeys.erase(firstKeys.begin() + source);
+        rebuildCounts();
+        return true;
+    }
+    
+    template <typename U>
+    void insertValue(U&& value) {
+        StoredKey key(keyOf(value));
+        
+        if (blocks.empty()) {
+            blocks.push_back(makeBlock());
+            firstKeys.push_back(key);
+            rebuildCounts();
+        }
+        
+        size_t b = locateBlock(key);
+        Block& block = blocks[b];
+        size_t pos = lowerPosition(block, key);
+        
+        if (pos < block.size() && !comp(key, block[pos].key)) {
+            // Duplicate - update the data
+            *block[pos].value = forward<U>(value);
+            return;
+        }
+        
+        T* stored = allocator.create(forward<U>(value));
+        block.insert(block.begin() + pos, Entry{move(key), stored});
+        if (pos == 0) {
+            firstKeys[b] = block.front().key;
+        }
+        count++;
+        
+        if (block.size() > MAX_BLOCK_SIZE) {
+            splitBlock(b);
+        } else {
+            addToCount(b, 1);
+        }
+    }
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        
+        const_iterator() : owner(nullptr), block(0), index(0) {}
+        
+        reference operator*() const { return *owner->blocks[block][index].value; }
+        pointer operator->() const { return owner->blocks[block][index].value; }
+        
+        const_iterator& operator++() {
+            if (++index == owner->blocks[block].size()) {
+                block++;
+                index = 0;
+            }
+            return *this;
+        }
+        
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++(*this);
+            return old;
+        }
+        
+        const_iterator& operator--() {
+            if (index == 0) {
+                block--;
+                index = owner->blocks[block].size();
+            }
+            index--;
+            return *this;
+        }
+        
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --(*this);
+            return old;
+        }
+        
+        bool operator==(const const_iterator& other) const {
+            return block == other.block && index == other.index;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    
+    private:
+        friend class BlockedSortedArray;
+        
+        // Positions one past the end of a block are normalised to the start of
+        // the next, so every element has exactly one iterator value.
+        const_iterator(const BlockedSortedArray* o, size_t b, size_t i) : owner(o), block(b), index(i) {
+            if (block < owner->blocks.size() && index == owner->blocks[block].size()) {
+                block++;
+                index = 0;
+            }
+        }
+        
+        const BlockedSortedArray* owner;
+        size_t block;
+        size_t index;
+    };
+    
+    using iterator = const_iterator;
+    
+    BlockedSortedArray() : count(0) {}
+    
+    BlockedSortedArray(const BlockedSortedArray&) = delete;
+    BlockedSortedArray& operator=(const BlockedSortedArray&) = delete;
+    
+    ~BlockedSortedArray() {
+        clear();
+    }
+    
+    void clear() {
+        if (!NodeAllocator<T>::releasesInBulk || !is_trivially_destructible<T>::value) {
+            for (Block& block : blocks) {
+                for (Entry& entry : block) {
+                    allocator.destroy(entry.value);
+                }
+            }
+        }
+        allocator.clear();
+        blocks.clear();
+        firstKeys.clear();
+        blockCounts.clear();
+        count = 0;
+    }
+    
+    // Same contract as AVLTree::buildFrom: O(n) for input already in strictly
+    // increasing key order, sort-then-build otherwise.
+    void buildFrom(vector<T> values) {
+        sortUniqueByKey(values, [this](const T& a, const T& b) {
+            return comp(keyOf(a), keyOf(b));
+        });
+        
+        clear();
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i % BLOCK_SIZE == 0) {
+                blocks.push_back(makeBlock());
+            }
+            T* stored = allocator.create(move(values[i]));
+            blocks.back().push_back(Entry{StoredKey(keyOf(*stored)), stored});
+            if (i % BLOCK_SIZE == 0) {
+                firstKeys.push_back(blocks.back().front().key);
+            }
+        }
+        count = values.size();
+        rebuildCounts();
+    }
+    
+    void insert(const T& value) {
+        insertValue(value);
+    }
+    
+    void insert(T&& value) {
+        insertValue(move(value));
+    }
+    
+    template <typename K>
+    bool remove(const K& value) {
+        if (blocks.empty()) {
+            return false;
+        }
+        
+        // Copy the key: `value` may be the element being destroyed.
+        StoredKey key(keyFor(value));
+        size_t b = locateBlock(key);
+        Block& block = blocks[b];
+        size_t pos = lowerPosition(block, key);
+        if (pos == block.size() || comp(key, block[pos].key)) {
+            return false;
+        }
+        
+        allocator.destroy(block[pos].value);
+        block.erase(block.begin() + pos);
+        count--;
+        
+        if (block.empty()) {
+            blocks.erase(blocks.begin() + b);
+            firstKeys.erase(firstKeys.begin() + b);
+            rebuildCounts();
+            return true;
+        }
+        
+        if (pos == 0) {
+            firstKeys[b] = block.front().key;
+        }
+        if (block.size() >= MIN_BLOCK_SIZE || !mergeBlock(b)) {
+            addToCount(b, -1);
+        }
+        return true;
+    }
+    
+    template <typename K>
+    bool search(const K& key) const {
+        return findValue(keyFor(key)) != nullptr;
+    }
+    
+    template <typename K>
+    T* find(const K& key) {
+        return findValue(keyFor(key));
+    }
+    
+    template <typename K>
+    const T* find(const K& key) const {
+        return findValue(keyFor(key));
+    }
+    
+    const_iterator begin() const {
+        return const_iterator(this, 0, 0);
+    }
+    
+    const_iterator end() const {
+        return const_iterator(this, blocks.size(), 0);
+    }
+    
+    template <typename K>
+    const_iterator lower_bound(const K& value) const {
+        if (blocks.empty()) {
+            return end();
+        }
+        const auto& key = keyFor(value);
+        size_t b = locateBlock(key);
+        return const_iterator(this, b, lowerPosition(blocks[b], key));
+    }
+    
+    template <typename K>
+    const_iterator upper_bound(const K& value) const {
+        if (blocks.empty()) {
+            return end();
+        }
+        const auto& key = keyFor(value);
+        size_t b = locateBlock(key);
+        return const_iterator(this, b, upperPosition(blocks[b], key));
+    }
+    
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const Block& block : blocks) {
+            for (const Entry& entry : block) {
+                if (!visitElement(visit, *entry.value)) {
+                    return;
+                }
+            }
+        }
+    }
+    
+    template <typename K1, typename K2, typename Visitor>
+    void forEachInRange(const K1& low, const K2& high, Visitor&& visit) const {
+        const auto& highKey = keyFor(high);
+        for (auto it = lower_bound(low); it != end(); ++it) {
+            const Entry& entry = blocks[it.block][it.index];
+            if (comp(highKey, entry.key) || !visitElement(visit, *entry.value)) {
+                return;
+            }
+        }
+    }
+    
+    template <typename Visitor>
+    void forEachWithPrefix(string_view prefix, Visitor&& visit) const {
+        for (auto it = lower_bound(prefix); it != end(); ++it) {
+            const Entry& entry = blocks[it.block][it.index];
+            if (string_view(entry.key).substr(0, prefix.size()) != prefix ||
+                !visitElement(visit, *entry.value)) {
+                return;
+            }
+        }
+    }
+    
+    vector<T> getAll() const {
+        vector<T> result;
+        result.reserve(count);
+        result.assign(begin(), end());
+        return result;
+    }
+    
+    bool isEmpty() const {
+        return count == 0;
+    }
+    
+    int size() const {
+        return count;
+    }
+    
+    template <typename K>
+    int rank(const K& value) const {
+        if (blocks.empty()) {
+            return 0;
+        }
+        const auto& key = keyFor(value);
+        size_t b = locateBlock(key);
+        return countBefore(b) + lowerPosition(blocks[b], key);
+    }
+    
+    // Descends the Fenwick tree to the block holding the k-th element.
+    const T* select(int k) const {
+        if (k < 0 || k >= count) {
+            return nullptr;
+        }
+        
+        size_t step = 1;
+        while (step * 2 < blockCounts.size()) {
+            step *= 2;
+        }
+        
+        size_t pos = 0;
+        for (; step > 0; step /= 2) {
+            if (pos + step < blockCounts.size() && blockCounts[pos + step] <= k) {
+                pos += step;
+                k -= blockCounts[pos];
+            }
+        }
+        
+        return blocks[pos][k].value;
+    }
+};
@@ -0,0 +1,464 @@
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <string_view>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+using namespace std;
+
+// Immutable (persistent) AVL tree with the same read interface as AVLTree.
+// Nodes are never modified once built: an update copies only the O(log n)
+// nodes on the path to the change and shares everything else with the
+// previous version through reference counts. Copying the tree, or taking a
+// snapshot(), is O(1) and the copy never changes afterwards. Elements are held
+// by shared pointer, so path copies don't copy them and a pointer to an
+// element stays valid for as long as any version still contains it.
+//
+// One writer may update the tree while other threads take snapshots or
+// iterate: the root is published and loaded atomically, iterators and
+// forEach() hold the version they walk, and everything reachable from a root
+// is immutable. find() and select() return raw pointers that a concurrent
+// remove() may free, so lookups on a tree that is being written need the
+// owner's lock; a snapshot() can be queried without one.
+template <typename T, typename KeyOf = IdentityKey, typename Compare = less<>>
+class PersistentAVLTree {
+private:
+    struct Node;
+    using NodePtr = shared_ptr<const Node>;
+    using ValuePtr = shared_ptr<const T>;
+    
+    struct Node {
+        ValuePtr value;
+        NodePtr left;
+        NodePtr right;
+        int height;
+        int size;
+        
+        Node(ValuePtr v, NodePtr l, NodePtr r)
+            : value(move(v)), left(move(l)), right(move(r)),
+              height(1 + max(getHeight(left), getHeight(right))),
+              size(1 + getSize(left) + getSize(right)) {}
+    };
+    
+    NodePtr root;
+    KeyOf keyOf;
+    Compare comp;
+    
+    template <typename K>
+    decltype(auto) keyFor(const K& value) const {
+        if constexpr (is_same<K, T>::value) {
+            return keyOf(value);
+        } else {
+            return (value);
+        }
+    }
+    
+    static int getHeight(const NodePtr& node) {
+        return node ? node->height : 0;
+    }
+    
+    static int getSize(const NodePtr& node) {
+        return node ? node->size : 0;
+    }
+    
+    static int getBalance(const NodePtr& node) {
+        return node ? getHeight(node->left) - getHeight(node->right) : 0;
+    }
+    
+    static NodePtr makeNode(ValuePtr value, NodePtr left, NodePtr right) {
+        return make_shared<const Node>(move(value), move(left), move(right));
+    }
+    
+    // Rotations and balancing build new nodes instead of relinking old ones.
+    static NodePtr rotateRight(const NodePtr& y) {
+        const NodePtr& x = y->left;
+        return makeNode(x->value, x->left, makeNode(y->value, x->right, y->right));
+    }
+    
+    static NodePtr rotateLeft(const NodePtr& x) {
+        const NodePtr& y = x->right;
+        return makeNode(y->value, makeNode(x->value, x->left, y->left), y->right);
+    }
+    
+    // Builds a node from its parts and restores the AVL invariant.
+    static NodePtr balanced(ValuePtr value, NodePtr left, NodePtr right) {
+        int balanceFactor = getHeight(left) - getHeight(right);
+        
+        if (balanceFactor > 1) {
+            if (getBalance(left) < 0) {
+                left = rotateLeft(left);
+            }
+            return rotateRight(makeNode(move(value), move(left), move(right)));
+        }
+        
+        if (balanceFactor < -1) {
+            if (getBalance(right) > 0) {
+                right = rotateRight(right);
+            }
+            return rotateLeft(makeNode(move(value), move(left), move(right)));
+        }
+        
+        return makeNode(move(value), move(left), move(right));
+    }
+    
+    template <typename K>
+    NodePtr insertNode(const NodePtr& node, const K& key, ValuePtr& value) const {
+        if (!node) {
+            return makeNode(move(value), nullptr, nullptr);
+        }
+        
+        if (comp(key, keyOf(*node->value))) {
+            return balanced(node->value, insertNode(node->left, key, value), node->right);
+        } else if (comp(keyOf(*node->value), key)) {
+            return balanced(node->value, node->left, insertNode(node->right, key, value));
+        } else {
+            // Duplicate - replace the element, keep the shape
+            return makeNode(move(value), node->left, node->right);
+        }
+    }
+    
+    // Returns the tree without its minimum, handing the minimum back in `minValue`.
+    NodePtr removeMin(const NodePtr& node, ValuePtr& minValue) const {
+        if (!node->left) {
+            minValue = node->value;
+            return node->right;
+        }
+        return balanced(node->value, removeMin(node->left, minValue), node->right);
+    }
+    
+    template <typename K>
+    NodePtr removeNode(const NodePtr& node, const K& key, bool& removed) const {
+        if (!node) {
+            return nullptr;
+        }
+        
+        if (comp(key, keyOf(*node->value))) {
+            NodePtr left = removeNode(node->left, key, removed);
+            return removed ? balanced(node->value, move(left), node->right) : node;
+        } else if (comp(keyOf(*node->value), key)) {
+            NodePtr right = removeNode(node->right, key, removed);
+            return removed ? balanced(node->value, node->left, move(right)) : node;
+        }
+        
+        removed = true;
+        if (!node->left) {
+            return node->right;
+        }
+        if (!node->right) {
+            return node->left;
+        }
+        
+        ValuePtr successor;
+        NodePtr right = removeMin(node->right, successor);
+        return balanced(move(successor), node->left, move(right));
+    }
+    
+    template <typename K>
+    const Node* searchNode(const K& key) const {
+        NodePtr version = loadRoot();
+        const Node* node = version.get();
+        while (node) {
+            if (comp(key, keyOf(*node->value))) {
+                node = node->left.get();
+            } else if (comp(keyOf(*node->value), key)) {
+                node = node->right.get();
+            } else {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+    
+    NodePtr buildBalanced(vector<T>& values, int first, int last) const {
+        if (first >= last) {
+            return nullptr;
+        }
+        
+        int middle = first + (last - first) / 2;
+        NodePtr left = buildBalanced(values, first, middle);
+        NodePtr right = buildBalanced(values, middle + 1, last);
+        return makeNode(make_shared<const T>(move(values[middle])), move(left), move(right));
+    }
+    
+    // In-order walk of one version; returns false once the visitor asks to stop.
+    template <typename Visitor>
+    static bool visitAll(const Node* node, Visitor& visit) {
+        if (!node) {
+            return true;
+        }
+        return visitAll(node->left.get(), visit) &&
+               visitElement(visit, *node->value) &&
+               visitAll(node->right.get(), visit);
+    }
+    
+    NodePtr loadRoot() const {
+        return atomic_load(&root);
+    }
+    
+    void publish(NodePtr newRoot) {
+        atomic_store(&root, move(newRoot));
+    }
+
+public:
+    // Bidirectional iterator over one version of the tree. Without parent
+    // links it carries the path from the root to the current node; it keeps
+    // that version alive, so it stays valid however the tree changes later.
+    class const_iterator {
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        
+        const_iterator() {}
+        
+        reference operator*() const { return *path.back()->value; }
+        pointer operator->() const { return path.back()->value.get(); }
+        
+        const_iterator& operator++() {
+            step(&Node::right, &Node::left);
+            return *this;
+        }
+        
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++(*this);
+            return old;
+        }
+        
+        const_iterator& operator--() {
+            if (path.empty()) {
+                // From end(): go to the largest element
+                for (const Node* node = version.get(); node; node = node->right.get()) {
+                    path.push_back(node);
+                }
+            } else {
+                step(&Node::left, &Node::right);
+            }
+            return *this;
+        }
+        
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --(*this);
+            return old;
+        }
+        
+        bool operator==(const const_iterator& other) const {
+            return (path.empty() ? nullptr : path.back()) ==
+                   (other.path.empty() ? nullptr : other.path.back());
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    
+    private:
+        friend class PersistentAVLTree;
+        
+        const_iterator(NodePtr v, vector<const Node*> p) : version(move(v)), path(move(p)) {}
+        
+        // One in-order step; `forward`/`backward` are right/left for ++ and
+        // left/right for --.
+        void step(NodePtr Node::* forward, NodePtr Node::* backward) {
+            const Node* node = path.back();
+            if ((node->*forward)) {
+                for (node = (node->*forward).get(); node; node = (node->*backward).get()) {
+                    path.push_back(node);
+                }
+                return;
+            }
+            
+            path.pop_back();
+            while (!path.empty() && (path.back()->*forward).get() == node) {
+                node = path.back();
+                path.pop_back();
+            }
+        }
+        
+        NodePtr version;
+        vector<const Node*> path;
+    };
+    
+    using iterator = const_iterator;
+    
+    PersistentAVLTree() {}
+    
+    PersistentAVLTree(const PersistentAVLTree& other) : root(other.loadRoot()) {}
+    
+    PersistentAVLTree& operator=(const PersistentAVLTree& other) {
+        publish(other.loadRoot());
+        return *this;
+    }
+    
+    // O(1): the returned tree shares every node with this one and is unaffected
+    // by later updates. Assigning it back restores this version.
+    PersistentAVLTree snapshot() const {
+        return *this;
+    }
+    
+    void clear() {
+        publish(nullptr);
+    }
+    
+    // Same contract as AVLTree::buildFrom.
+    void buildFrom(vector<T> values) {
+        sortUniqueByKey(values, [this](const T& a, const T& b) {
+            return comp(keyOf(a), keyOf(b));
+        });
+        publish(buildBalanced(values, 0, values.size()));
+    }
+    
+    void insert(const T& value) {
+        ValuePtr stored = make_shared<const T>(value);
+        publish(insertNode(root, keyOf(*stored), stored));
+    }
+    
+    template <typename K>
+    bool remove(const K& value) {
+        bool removed = false;
+        NodePtr newRoot = removeNode(root, keyFor(value), removed);
+        if (removed) {
+            publish(move(newRoot));
+        }
+        return removed;
+    }
+    
+    template <typename K>
+    bool search(const K& key) const {
+        return searchNode(keyFor(key)) != nullptr;
+    }
+    
+    // Elements are shared between versions, so only const access is offered;
+    // change an element by inserting a new one with the same key.
+    template <typename K>
+    const T* find(const K& key) const {
+        const Node* node = searchNode(keyFor(key));
+        return node ? node->value.get() : nullptr;
+    }
+    
+    const_iterator begin() const {
+        NodePtr version = loadRoot();
+        vector<const Node*> path;
+        for (const Node* node = version.get(); node; node = node->left.get()) {
+            path.push_back(node);
+        }
+        return const_iterator(move(version), move(path));
+    }
+    
+    const_iterator end() const {
+        return const_iterator(loadRoot(), {});
+    }
+    
+    template <typename K>
+    const_iterator lower_bound(const K& key) const {
+        return bound(keyFor(key), false);
+    }
+    
+    template <typename K>
+    const_iterator upper_bound(const K& key) const {
+        return bound(keyFor(key), true);
+    }
+    
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        NodePtr version = loadRoot();
+        visitAll(version.get(), visit);
+    }
+    
+    template <typename K1, typename K2, typename Visitor>
+    void forEachInRange(const K1& low, const K2& high, Visitor&& visit) const {
+        const auto& highKey = keyFor(high);
+        const auto stop = end();
+        for (auto it = lower_bound(low); it != stop; ++it) {
+            if (comp(highKey, keyOf(*it)) || !visitElement(visit, *it)) {
+                return;
+            }
+        }
+    }
+    
+    template <typename Visitor>
+    void forEachWithPrefix(string_view prefix, Visitor&& visit) const {
+        const auto stop = end();
+        for (auto it = lower_bound(prefix); it != stop; ++it) {
+            if (string_view(keyOf(*it)).substr(0, prefix.size()) != prefix ||
+                !visitElement(visit, *it)) {
+                return;
+            }
+        }
+    }
+    
+    vector<T> getAll() const {
+        vector<T> result;
+        result.reserve(size());
+        forEach([&](const T& value) { result.push_back(value); });
+        return result;
+    }
+    
+    bool isEmpty() const {
+        return !loadRoot();
+    }
+    
+    int size() const {
+        return getSize(loadRoot());
+    }
+    
+    template <typename K>
+    int rank(const K& key) const {
+        const auto& target = keyFor(key);
+        int result = 0;
+        NodePtr version = loadRoot();
+        const Node* node = version.get();
+        while (node) {
+            if (comp(keyOf(*node->value), target)) {
+                result += getSize(node->left) + 1;
+                node = node->right.get();
+            } else {
+                node = node->left.get();
+            }
+        }
+        return result;
+    }
+    
+    const T* select(int k) const {
+        NodePtr version = loadRoot();
+        const Node* node = version.get();
+        while (node) {
+            int leftSize = getSize(node->left);
+            if (k < leftSize) {
+                node = node->left.get();
+            } else if (k == leftSize) {
+                return node->value.get();
+            } else {
+                k -= leftSize + 1;
+                node = node->right.get();
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    template <typename K>
+    const_iterator bound(const K& key, bool strict) const {
+        NodePtr version = loadRoot();
+        vector<const Node*> path;
+        size_t resultDepth = 0;     // path length up to the best candidate so far
+        
+        for (const Node* node = version.get(); node; ) {
+            path.push_back(node);
+            bool goLeft = strict ? comp(key, keyOf(*node->value))
+                                 : !comp(keyOf(*node->value), key);
+            if (goLeft) {
+                resultDepth = path.size();
+                node = node->left.get();
+            } else {
+                node = node->right.get();
+            }
+        }
+        
+        path.resize(resultDepth);
+        return const_iterator(move(version), move(path));
+    }
+};
@@ -0,0 +1,112 @@
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+using namespace std;
+
+// Node allocators for the tree containers. An allocator hands out storage for
+// one node at a time through create()/destroy() and may give all of its memory
+// back at once through clear() once every live node has been destroyed.
+
+// Slab/arena allocator: nodes are carved out of large contiguous blocks so that
+// neighbouring nodes share cache lines, and removed nodes are recycled through
+// an intrusive free list.
+template <typename Node>
+class PoolAllocator {
+private:
+    union Slot {
+        Slot* next;
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+    
+    static constexpr size_t MIN_SLAB_SIZE = 64;
+    static constexpr size_t MAX_SLAB_SIZE = 16384;
+    
+    vector<unique_ptr<Slot[]>> slabs;
+    Slot* freeList;
+    Slot* cursor;       // next unused slot in the current slab
+    Slot* slabEnd;
+    size_t nextSlabSize;
+    
+    void addSlab(size_t count) {
+        slabs.emplace_back(new Slot[count]);
+        cursor = slabs.back().get();
+        slabEnd = cursor + count;
+    }
+    
+    void* allocateSlot() {
+        if (freeList) {
+            Slot* slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        
+        if (cursor == slabEnd) {
+            addSlab(nextSlabSize);
+            nextSlabSize = min(nextSlabSize * 2, MAX_SLAB_SIZE);
+        }
+        
+        return cursor++;
+    }
+
+public:
+    // Destroying nodes only returns their slot to the free list, so the tree
+    // may skip the per-node walk entirely when the payload needs no destructor.
+    static constexpr bool releasesInBulk = true;
+    
+    PoolAllocator() : freeList(nullptr), cursor(nullptr), slabEnd(nullptr),
+                      nextSlabSize(MIN_SLAB_SIZE) {}
+    
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+    
+    template <typename... Args>
+    Node* create(Args&&... args) {
+        void* slot = allocateSlot();
+        try {
+            return new (slot) Node(forward<Args>(args)...);
+        } catch (...) {
+            Slot* freed = static_cast<Slot*>(slot);
+            freed->next = freeList;
+            freeList = freed;
+            throw;
+        }
+    }
+    
+    void destroy(Node* node) {
+        node->~Node();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+    
+    // Releases every slab. All live nodes must have been destroyed first.
+    void clear() {
+        slabs.clear();
+        freeList = nullptr;
+        cursor = nullptr;
+        slabEnd = nullptr;
+        nextSlabSize = MIN_SLAB_SIZE;
+    }
+};
+
+// Plain new/delete per node; kept for comparison and for callers that need
+// memory handed back to the system as soon as a node is removed.
+template <typename Node>
+class HeapAllocator {
+public:
+    static constexpr bool releasesInBulk = false;
+    
+    template <typename... Args>
+    Node* create(Args&&... args) {
+        return new Node(forward<Args>(args)...);
+    }
+    
+    void destroy(Node* node) {
+        delete node;
+    }
+    
+    void clear() {}
+};
@@ -0,0 +1,169 @@
+#include <vector>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// Counters reported by QueryCache::getStats().
+struct QueryCacheStats {
+    long long hits;
+    long long misses;
+    long long evictions;
+    size_t entries;
+    size_t cachedRows;
+    
+    QueryCacheStats() : hits(0), misses(0), evictions(0), entries(0), cachedRows(0) {}
+};
+
+// LRU cache of search results keyed by the canonical form of a query. Each
+// entry records the roster version it was computed at and is only returned
+// while the caller's version still matches, so bumping the version on every
+// write invalidates everything without touching the cache. Memory is bounded
+// by the total number of cached rows; a result larger than the whole budget
+// is not cached. Safe to call from concurrent readers.
+class QueryCache {
+private:
+    struct Entry {
+        string key;
+        uint64_t version;
+        shared_ptr<const vector<Student>> results;
+        
+        Entry(const string& k, uint64_t v, shared_ptr<const vector<Student>> r)
+            : key(k), version(v), results(move(r)) {}
+    };
+    
+    list<Entry> entries;        // most recently used first
+    unordered_map<string, list<Entry>::iterator> byKey;
+    size_t capacityRows;
+    size_t cachedRows;
+    QueryCacheStats stats;
+    mutable mutex cacheMutex;
+    
+    // Rows charged for an entry; an empty result still takes a slot.
+    static size_t cost(const Entry& entry) { return max<size_t>(1, entry.results->size()); }
+    
+    void erase(list<Entry>::iterator it);
+
+public:
+    explicit QueryCache(size_t capacityRows = 100000) : capacityRows(capacityRows), cachedRows(0) {}
+    
+    // Criteria that always select the same students map to the same key:
+    // name searches are case-insensitive, so their needles are folded.
+    static string keyFor(const SearchCriteria& criteria, SearchMode mode);
+    
+    // The result cached at `version`, or nullptr. Results are shared and
+    // immutable, so hits are copied out by the caller outside the lock.
+    shared_ptr<const vector<Student>> lookup(const string& key, uint64_t version);
+    void store(const string& key, uint64_t version, const vector<Student>& results);
+    
+    // A capacity of 0 disables the cache.
+    void setCapacity(size_t rows);
+    void clear();
+    QueryCacheStats getStats() const;
+};
+
+
+string QueryCache::keyFor(const SearchCriteria& criteria, SearchMode mode) {
+    const char separator = '\x1f';
+    string key;
+    key += mode == SearchMode::MATCH_ALL ? '&' : '|';
+    for (const string* field : {&criteria.id, &criteria.idPrefix, &criteria.idFrom, &criteria.idTo,
+                                &criteria.department, &criteria.section}) {
+        key += separator;
+        key += *field;
+    }
+    key += separator + Utils::toLower(criteria.firstName);
+    key += separator + Utils::toLower(criteria.lastName);
+    key += separator + to_string(criteria.age);
+    key += separator;
+    key += criteria.sex;
+    key += separator + to_string(criteria.yearOfStudy);
+    // GPA bounds go in as their raw bytes: to_string() rounds to six
+    // decimals, which would merge bounds like 3.1666664 and 3.1666668.
+    for (double bound : {criteria.minGPA, criteria.maxGPA}) {
+        char bytes[sizeof(double)];
+        memcpy(bytes, &bound, sizeof(double));
+        key += separator;
+        key.append(bytes, sizeof(double));
+    }
+    return key;
+}
+
+void QueryCache::erase(list<Entry>::iterator it) {
+    cachedRows -= cost(*it);
+    byKey.erase(it->key);
+    entries.erase(it);
+}
+
+shared_ptr<const vector<Student>> QueryCache::lookup(const string& key, uint64_t version) {
+    lock_guard<mutex> lock(cacheMutex);
+    auto found = byKey.find(key);
+    if (found == byKey.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+    
+    if (found->second->version != version) {
+        erase(found->second);
+        stats.misses++;
+        return nullptr;
+    }
+    
+    entries.splice(entries.begin(), entries, found->second);
+    stats.hits++;
+    return found->second->results;
+}
+
+void QueryCache::store(const string& key, uint64_t version, const vector<Student>& results) {
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        if (max<size_t>(1, results.size()) > capacityRows) {
+            return;
+        }
+    }
+    auto shared = make_shared<const vector<Student>>(results);
+    
+    lock_guard<mutex> lock(cacheMutex);
+    auto found = byKey.find(key);
+    if (found != byKey.end()) {
+        erase(found->second);
+    }
+    
+    entries.emplace_front(key, version, move(shared));
+    byKey[key] = entries.begin();
+    cachedRows += cost(entries.front());
+    
+    while (cachedRows > capacityRows) {
+        erase(prev(entries.end()));
+        stats.evictions++;
+    }
+}
+
+void QueryCache::setCapacity(size_t rows) {
+    lock_guard<mutex> lock(cacheMutex);
+    capacityRows = rows;
+    while (cachedRows > capacityRows) {
+        erase(prev(entries.end()));
+        stats.evictions++;
+    }
+}
+
+void QueryCache::clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    entries.clear();
+    byKey.clear();
+    cachedRows = 0;
+}
+
+QueryCacheStats QueryCache::getStats() const {
+    lock_guard<mutex> lock(cacheMutex);
+    QueryCacheStats result = stats;
+    result.entries = entries.size();
+    result.cachedRows = cachedRows;
+    return result;
+}
@@ -0,0 +1,1080 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+
+// Student attribute read by a query predicate. The COURSE_ fields read the
+// student's result in one course, named in the predicate (SWEG3103.grade).
+enum class QueryField {
+    ID,
+    FIRST_NAME,
+    LAST_NAME,
+    DEPARTMENT,
+    SECTION,
+    AGE,
+    SEX,
+    YEAR_OF_STUDY,
+    GPA,
+    COURSE_GRADE,
+    COURSE_SCORE,       // assessment + final exam
+    COURSE_ASSESSMENT,
+    COURSE_FINAL
+};
+
+enum class QueryOp {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    CONTAINS,
+    PREFIX
+};
+
+// One node of a compiled query: a comparison against one field, a constant,
+// or AND/OR/NOT over child nodes.
+struct QueryNode {
+    enum class Kind { COMPARE, CONSTANT, AND, OR, NOT };
+    
+    Kind kind;
+    bool value;                 // CONSTANT
+    QueryField field;           // COMPARE
+    QueryOp op;
+    string course;              // course code of the COURSE_ fields
+    string text;                // text operand; names are case-folded, grades upper-case
+    double number;              // numeric operand; a grade's rank
+    vector<QueryNode> children;
+    double selectivity;         // estimated share of the roster that passes
+    double cost;                // estimated work per student, in simple field checks
+    
+    QueryNode() : kind(Kind::CONSTANT), value(true), field(QueryField::ID), op(QueryOp::EQUAL),
+                  number(0), selectivity(1), cost(0) {}
+    
+    static QueryNode constant(bool value);
+    
+    bool matches(const Student& student) const;
+    
+    // Canonical text of the node, which parses back to the same tree.
+    string toString() const;
+};
+
+// Compiles the free-form query language into a QueryNode tree:
+//
+//   (dept=SE and year=3) or gpa>=3.9
+//   SWEG3103.grade>=B and not section=A
+//   first~abe last=gul*
+//
+// Comparisons are `field op value`, with op one of = != < <= > >= and ~
+// (contains). A value ending in * after = is a prefix. Fields are id, first,
+// last, dept, section, age, sex, year, gpa and COURSE.grade / .score /
+// .assessment / .final. Names match case-insensitively; grades compare by
+// rank (F < C- < ... < A+). A course predicate is false for a student who
+// hasn't taken the course. Values may be quoted with " or ', and a
+// backslash inside quotes escapes the next character. Terms combine with
+// and/or/not (or && || !) and parentheses; and binds tighter than or and may
+// be left out.
+class QueryCompiler {
+public:
+    // Parses and type-checks `text` into `root` and folds constants. Returns
+    // false with a message in `error` if the query is malformed.
+    static bool compile(const string& text, QueryNode& root, string& error);
+    
+    // Estimates every node's selectivity and cost from the roster statistics
+    // and reorders AND/OR children so the cheapest, most decisive checks run
+    // first. Only the evaluation order changes, never the result.
+    template <typename Store>
+    static void optimize(QueryNode& root, const Store& store, const StudentIndex& index);
+    
+    // The top-level AND terms that SearchCriteria can express. Every match of
+    // `root` meets them, so QueryPlanner can pick an index from them and the
+    // whole tree is then checked on its candidates.
+    static SearchCriteria pushdownCriteria(const QueryNode& root);
+    
+    // The tree, one node per line, with estimates after optimize().
+    static string explain(const QueryNode& root);
+    
+    static string fieldName(QueryField field);
+    static string opName(QueryOp op);
+    static bool isNumeric(QueryField field);
+    static bool isCourseField(QueryField field);
+    
+    // Position of a letter grade from F up to A+, or -1 if it isn't one.
+    static int gradeRank(const string& grade);
+
+private:
+    struct Token {
+        enum class Type { WORD, STRING, OPERATOR, LEFT_PAREN, RIGHT_PAREN, END };
+        
+        Type type;
+        string text;
+        
+        Token(Type t, const string& s) : type(t), text(s) {}
+    };
+    
+    struct Parser {
+        vector<Token> tokens;
+        size_t pos;
+        string error;
+        
+        Parser() : pos(0) {}
+        
+        const Token& peek() const { return tokens[pos]; }
+        bool peekKeyword(const string& keyword) const;
+        bool peekAnd() const;
+        bool peekOr() const;
+        bool startsTerm() const;
+        
+        bool parseOr(QueryNode& node);
+        bool parseAnd(QueryNode& node);
+        bool parseUnary(QueryNode& node);
+        bool parseComparison(QueryNode& node);
+    };
+    
+    static bool tokenize(const string& text, vector<Token>& tokens, string& error);
+    static bool compileComparison(const string& fieldText, const string& opText, const Token& value,
+                                  QueryNode& node, string& error);
+    static bool parseNumber(const string& text, double& number);
+    
+    static void fold(QueryNode& node);
+    static bool contradicts(const vector<QueryNode>& terms);
+    static bool invert(QueryOp op, QueryOp& inverse);
+    
+    template <typename Store>
+    static double estimate(const QueryNode& node, const Store& store, const StudentIndex& index);
+    static double leafCost(const QueryNode& node);
+    
+    static void explainNode(const QueryNode& node, int depth, stringstream& out);
+};
+
+
+QueryNode QueryNode::constant(bool value) {
+    QueryNode node;
+    node.kind = Kind::CONSTANT;
+    node.value = value;
+    node.selectivity = value ? 1 : 0;
+    return node;
+}
+
+bool QueryNode::matches(const Student& student) const {
+    switch (kind) {
+        case Kind::CONSTANT:
+            return value;
+        
+        case Kind::AND:
+            for (const QueryNode& child : children) {
+                if (!child.matches(student)) return false;
+            }
+            return true;
+        
+        case Kind::OR:
+            for (const QueryNode& child : children) {
+                if (child.matches(student)) return true;
+            }
+            return false;
+        
+        case Kind::NOT:
+            return !children[0].matches(student);
+        
+        case Kind::COMPARE:
+            break;
+    }
+    
+    // Text fields compare as strings, the rest as numbers.
+    const string* actualText = nullptr;
+    string copied;
+    double actual = 0;
+    switch (field) {
+        case QueryField::ID: actualText = &student.getId(); break;
+        case QueryField::FIRST_NAME: actualText = &student.getFirstNameKey(); break;
+        case QueryField::LAST_NAME: actualText = &student.getLastNameKey(); break;
+        case QueryField::DEPARTMENT: copied = student.getDepartment(); actualText = &copied; break;
+        case QueryField::SECTION: copied = student.getSection(); actualText = &copied; break;
+        case QueryField::SEX:
+            copied = string(1, static_cast<char>(toupper(static_cast<unsigned char>(student.getSex()))));
+            actualText = &copied;
+            break;
+        case QueryField::AGE: actual = student.getAge(); break;
+        case QueryField::YEAR_OF_STUDY: actual = student.getYearOfStudy(); break;
+        case QueryField::GPA: actual = student.getGPA(); break;
+        default: {
+            const map<string, CourseResult>& courses = student.getCourses();
+            auto found = courses.find(course);
+            if (found == courses.end()) {
+                return false;
+            }
+            const CourseResult& result = found->second;
+            if (field == QueryField::COURSE_GRADE) {
+                actual = QueryCompiler::gradeRank(result.grade);
+            } else if (field == QueryField::COURSE_SCORE) {
+                actual = result.getTotalScore();
+            } else if (field == QueryField::COURSE_ASSESSMENT) {
+                actual = result.assessment;
+            } else {
+                actual = result.finalExam;
+            }
+        }
+    }
+    
+    if (actualText) {
+        const string& value = *actualText;
+        switch (op) {
+            case QueryOp::EQUAL: return value == text;
+            case QueryOp::NOT_EQUAL: return value != text;
+            case QueryOp::LESS: return value < text;
+            case QueryOp::LESS_EQUAL: return value <= text;
+            case QueryOp::GREATER: return value > text;
+            case QueryOp::GREATER_EQUAL: return value >= text;
+            case QueryOp::CONTAINS: return value.find(text) != string::npos;
+            case QueryOp::PREFIX: return value.compare(0, text.size(), text) == 0;
+        }
+        return false;
+    }
+    
+    switch (op) {
+        case QueryOp::EQUAL: return actual == number;
+        case QueryOp::NOT_EQUAL: return actual != number;
+        case QueryOp::LESS: return actual < number;
+        case QueryOp::LESS_EQUAL: return actual <= number;
+        case QueryOp::GREATER: return actual > number;
+        case QueryOp::GREATER_EQUAL: return actual >= number;
+        default: return false;
+    }
+}
+
+string QueryNode::toString() const {
+    switch (kind) {
+        case Kind::CONSTANT:
+            return value ? "true" : "false";
+        
+        case Kind::NOT: {
+            const QueryNode& child = children[0];
+            bool simple = child.kind == Kind::COMPARE || child.kind == Kind::CONSTANT;
+            return "not " + (simple ? child.toString() : "(" + child.toString() + ")");
+        }
+        
+        case Kind::AND:
+        case Kind::OR: {
+            string result;
+            for (size_t i = 0; i < children.size(); ++i) {
+                if (i > 0) result += kind == Kind::AND ? " and " : " or ";
+                // OR binds looser than AND, so it needs parentheses inside one.
+                bool wrap = kind == Kind::AND && children[i].kind == Kind::OR;
+                result += wrap ? "(" + children[i].toString() + ")" : children[i].toString();
+            }
+            return result;
+        }
+        
+        case Kind::COMPARE:
+            break;
+    }
+    
+    string result = course.empty() ? QueryCompiler::fieldName(field)
+                                   : course + "." + QueryCompiler::fieldName(field);
+    result += " " + QueryCompiler::opName(op) + " ";
+    
+    bool textual = !QueryCompiler::isNumeric(field) || field == QueryField::COURSE_GRADE;
+    if (!textual) {
+        stringstream formatted;
+        formatted << setprecision(numeric_limits<double>::max_digits10) << number;
+        return result + formatted.str();
+    }
+    
+    // Quote text that would not read back as a single word.
+    bool plain = !text.empty() && text.find_first_of(" \t()<>=!~&|\"'*\\") == string::npos;
+    string value = text;
+    if (!plain) {
+        value = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') value += '\\';
+            value += c;
+        }
+        value += '"';
+    }
+    return result + value + (op == QueryOp::PREFIX ? "*" : "");
+}
+
+bool QueryCompiler::compile(const string& text, QueryNode& root, string& error) {
+    Parser parser;
+    if (!tokenize(text, parser.tokens, error)) {
+        return false;
+    }
+    if (parser.peek().type == Token::Type::END) {
+        error = "Empty query";
+        return false;
+    }
+    
+    QueryNode parsed;
+    if (!parser.parseOr(parsed)) {
+        error = parser.error;
+        return false;
+    }
+    if (parser.peek().type != Token::Type::END) {
+        error = "Unexpected '" + parser.peek().text + "'";
+        return false;
+    }
+    
+    fold(parsed);
+    root = move(parsed);
+    return true;
+}
+
+bool QueryCompiler::tokenize(const string& text, vector<Token>& tokens, string& error) {
+    const string wordBreaks = " \t\r\n()<>=!~&|\"'";
+    size_t i = 0;
+    
+    while (i < text.size()) {
+        char c = text[i];
+        if (isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '(') {
+            tokens.emplace_back(Token::Type::LEFT_PAREN, "(");
+            ++i;
+        } else if (c == ')') {
+            tokens.emplace_back(Token::Type::RIGHT_PAREN, ")");
+            ++i;
+        } else if (c == '"' || c == '\'') {
+            // A backslash takes the next character literally.
+            string quoted;
+            size_t close = i + 1;
+            for (; close < text.size() && text[close] != c; ++close) {
+                if (text[close] == '\\' && close + 1 < text.size()) ++close;
+                quoted += text[close];
+            }
+            if (close == text.size()) {
+                error = "Missing closing quote";
+                return false;
+            }
+            tokens.emplace_back(Token::Type::STRING, quoted);
+            i = close + 1;
+        } else if (wordBreaks.find(c) != string::npos) {
+            // Two-character operators first: <= >= != == && ||
+            string two = text.substr(i, 2);
+            if (two == "<=" || two == ">=" || two == "!=" || two == "==" || two == "&&" || two == "||") {
+                tokens.emplace_back(Token::Type::OPERATOR, two == "==" ? "=" : two);
+                i += 2;
+            } else if (c == '&' || c == '|') {
+                error = string("Unexpected '") + c + "' (use && or ||)";
+                return false;
+            } else {
+                tokens.emplace_back(Token::Type::OPERATOR, string(1, c));
+                ++i;
+            }
+        } else {
+            size_t end = text.find_first_of(wordBreaks, i);
+            if (end == string::npos) end = text.size();
+            tokens.emplace_back(Token::Type::WORD, text.substr(i, end - i));
+            i = end;
+        }
+    }
+    
+    tokens.emplace_back(Token::Type::END, "end of query");
+    return true;
+}
+
+bool QueryCompiler::Parser::peekKeyword(const string& keyword) const {
+    return peek().type == Token::Type::WORD && Utils::toLower(peek().text) == keyword;
+}
+
+bool QueryCompiler::Parser::peekAnd() const {
+    return peekKeyword("and") || (peek().type == Token::Type::OPERATOR && peek().text == "&&");
+}
+
+bool QueryCompiler::Parser::peekOr() const {
+    return peekKeyword("or") || (peek().type == Token::Type::OPERATOR && peek().text == "||");
+}
+
+// Whether the next token can begin a term, which makes AND implicit.
+bool QueryCompiler::Parser::startsTerm() const {
+    const Token& token = peek();
+    if (token.type == Token::Type::LEFT_PAREN) return true;
+    if (token.type == Token::Type::OPERATOR) return token.text == "!";
+    return token.type == Token::Type::WORD && !peekOr() && !peekAnd();
+}
+
+bool QueryCompiler::Parser::parseOr(QueryNode& node) {
+    if (!parseAnd(node)) {
+        return false;
+    }
+    
+    while (peekOr()) {
+        pos++;
+        QueryNode right;
+        if (!parseAnd(right)) {
+            return false;
+        }
+        if (node.kind != QueryNode::Kind::OR) {
+            QueryNode either;
+            either.kind = QueryNode::Kind::OR;
+            either.children.push_back(move(node));
+            node = move(either);
+        }
+        node.children.push_back(move(right));
+    }
+    return true;
+}
+
+bool QueryCompiler::Parser::parseAnd(QueryNode& node) {
+    if (!parseUnary(node)) {
+        return false;
+    }
+    
+    while (peekAnd() || startsTerm()) {
+        if (peekAnd()) pos++;
+        QueryNode right;
+        if (!parseUnary(right)) {
+            return false;
+        }
+        if (node.kind != QueryNode::Kind::AND) {
+            QueryNode both;
+            both.kind = QueryNode::Kind::AND;
+            both.children.push_back(move(node));
+            node = move(both);
+        }
+        node.children.push_back(move(right));
+    }
+    return true;
+}
+
+bool QueryCompiler::Parser::parseUnary(QueryNode& node) {
+    const Token& token = peek();
+    
+    if (peekKeyword("not") || (token.type == Token::Type::OPERATOR && token.text == "!")) {
+        pos++;
+        QueryNode child;
+        if (!parseUnary(child)) {
+            return false;
+        }
+        node = QueryNode();
+        node.kind = QueryNode::Kind::NOT;
+        node.children.push_back(move(child));
+        return true;
+    }
+    
+    if (token.type == Token::Type::LEFT_PAREN) {
+        pos++;
+        if (!parseOr(node)) {
+            return false;
+        }
+        if (peek().type != Token::Type::RIGHT_PAREN) {
+            error = "Missing ')' before " + (peek().type == Token::Type::END ? peek().text
+                                                                            : "'" + peek().text + "'");
+            return false;
+        }
+        pos++;
+        return true;
+    }
+    
+    if (peekKeyword("true") || peekKeyword("false")) {
+        node = QueryNode::constant(peekKeyword("true"));
+        pos++;
+        return true;
+    }
+    
+    return parseComparison(node);
+}
+
+bool QueryCompiler::Parser::parseComparison(QueryNode& node) {
+    const Token& field = peek();
+    if (field.type != Token::Type::WORD) {
+        error = "Expected a field name, found " + (field.type == Token::Type::END ? field.text
+                                                                                  : "'" + field.text + "'");
+        return false;
+    }
+    pos++;
+    
+    const Token& op = peek();
+    if (op.type != Token::Type::OPERATOR || op.text == "!" || op.text == "&&" || op.text == "||") {
+        error = "Expected an operator (= != < <= > >= ~) after '" + field.text + "'";
+        return false;
+    }
+    pos++;
+    
+    const Token& value = peek();
+    if (value.type != Token::Type::WORD && value.type != Token::Type::STRING) {
+        error = "Expected a value after '" + field.text + " " + op.text + "'";
+        return false;
+    }
+    pos++;
+    
+    return compileComparison(field.text, op.text, value, node, error);
+}
+
+bool QueryCompiler::compileComparison(const string& fieldText, const string& opText,
+                                      const Token& value, QueryNode& node, string& error) {
+    node = QueryNode();
+    node.kind = QueryNode::Kind::COMPARE;
+    
+    string name = Utils::toLower(fieldText);
+    size_t dot = fieldText.rfind('.');
+    if (dot != string::npos) {
+        node.course = fieldText.substr(0, dot);
+        name = name.substr(dot + 1);
+    }
+    
+    static const vector<pair<string, QueryField>> studentFields = {
+        {"id", QueryField::ID}, {"first", QueryField::FIRST_NAME},
+        {"firstname", QueryField::FIRST_NAME}, {"last", QueryField::LAST_NAME},
+        {"lastname", QueryField::LAST_NAME}, {"dept", QueryField::DEPARTMENT},
+        {"department", QueryField::DEPARTMENT}, {"section", QueryField::SECTION},
+        {"age", QueryField::AGE}, {"sex", QueryField::SEX}, {"year", QueryField::YEAR_OF_STUDY},
+        {"gpa", QueryField::GPA}
+    };
+    static const vector<pair<string, QueryField>> courseFields = {
+        {"grade", QueryField::COURSE_GRADE}, {"score", QueryField::COURSE_SCORE},
+        {"total", QueryField::COURSE_SCORE}, {"assessment", QueryField::COURSE_ASSESSMENT},
+        {"final", QueryField::COURSE_FINAL}
+    };
+    
+    const vector<pair<string, QueryField>>& known = node.course.empty() ? studentFields : courseFields;
+    auto found = find_if(known.begin(), known.end(),
+                         [&](const pair<string, QueryField>& entry) { return entry.first == name; });
+    if (found == known.end()) {
+        error = "Unknown field '" + fieldText + "'";
+        return false;
+    }
+    node.field = found->second;
+    
+    static const vector<pair<string, QueryOp>> ops = {
+        {"=", QueryOp::EQUAL}, {"!=", QueryOp::NOT_EQUAL}, {"<", QueryOp::LESS},
+        {"<=", QueryOp::LESS_EQUAL}, {">", QueryOp::GREATER}, {">=", QueryOp::GREATER_EQUAL},
+        {"~", QueryOp::CONTAINS}
+    };
+    node.op = find_if(ops.begin(), ops.end(),
+                      [&](const pair<string, QueryOp>& entry) { return entry.first == opText; })->second;
+    
+    string text = value.text;
+    bool wildcard = value.type == Token::Type::WORD && text.size() > 1 && text.back() == '*';
+    bool ordered = node.op != QueryOp::EQUAL && node.op != QueryOp::NOT_EQUAL &&
+                   node.op != QueryOp::CONTAINS;
+    
+    switch (node.field) {
+        case QueryField::FIRST_NAME:
+        case QueryField::LAST_NAME:
+        case QueryField::DEPARTMENT:
+        case QueryField::SECTION:
+            if (ordered) {
+                error = "Operator " + opText + " does not apply to " + fieldName(node.field);
+                return false;
+            }
+            [[fallthrough]];
+        case QueryField::ID: {
+            bool excluded = wildcard && node.op == QueryOp::NOT_EQUAL;
+            if (wildcard && (node.op == QueryOp::EQUAL || excluded)) {
+                node.op = QueryOp::PREFIX;
+                text.pop_back();
+            }
+            node.text = node.field == QueryField::FIRST_NAME || node.field == QueryField::LAST_NAME
+                ? Utils::toLower(text) : text;
+            if (excluded) {
+                QueryNode prefix = move(node);
+                node = QueryNode();
+                node.kind = QueryNode::Kind::NOT;
+                node.children.push_back(move(prefix));
+            }
+            return true;
+        }
+        
+        case QueryField::SEX:
+            if (node.op != QueryOp::EQUAL && node.op != QueryOp::NOT_EQUAL) {
+                error = "Operator " + opText + " does not apply to sex";
+                return false;
+            }
+            if (!Utils::isValidSex(text.size() == 1 ? text[0] : '\0')) {
+                error = "Sex must be M or F, not '" + text + "'";
+                return false;
+            }
+            node.text = string(1, static_cast<char>(toupper(static_cast<unsigned char>(text[0]))));
+            return true;
+        
+        case QueryField::COURSE_GRADE:
+            if (node.op == QueryOp::CONTAINS) {
+                error = "Operator ~ does not apply to grades";
+                return false;
+            }
+            node.text = text;
+            transform(node.text.begin(), node.text.end(), node.text.begin(),
+                      [](unsigned char c) { return toupper(c); });
+            node.number = gradeRank(node.text);
+            if (node.number < 0) {
+                error = "Unknown grade '" + text + "'";
+                return false;
+            }
+            return true;
+        
+        default:
+            if (node.op == QueryOp::CONTAINS) {
+                error = "Operator ~ does not apply to " + fieldName(node.field);
+                return false;
+            }
+            if (!parseNumber(text, node.number)) {
+                error = "'" + text + "' is not a number (" + fieldName(node.field) + ")";
+                return false;
+            }
+            return true;
+    }
+}
+
+bool QueryCompiler::parseNumber(const string& text, double& number) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    number = strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+int QueryCompiler::gradeRank(const string& grade) {
+    static const vector<string> grades = {"F", "C-", "C", "C+", "B-", "B", "B+", "A-", "A", "A+"};
+    auto found = find(grades.begin(), grades.end(), grade);
+    return found == grades.end() ? -1 : static_cast<int>(found - grades.begin());
+}
+
+bool QueryCompiler::isNumeric(QueryField field) {
+    return field == QueryField::AGE || field == QueryField::YEAR_OF_STUDY || field == QueryField::GPA ||
+           isCourseField(field);
+}
+
+bool QueryCompiler::isCourseField(QueryField field) {
+    return field == QueryField::COURSE_GRADE || field == QueryField::COURSE_SCORE ||
+           field == QueryField::COURSE_ASSESSMENT || field == QueryField::COURSE_FINAL;
+}
+
+bool QueryCompiler::invert(QueryOp op, QueryOp& inverse) {
+    switch (op) {
+        case QueryOp::EQUAL: inverse = QueryOp::NOT_EQUAL; return true;
+        case QueryOp::NOT_EQUAL: inverse = QueryOp::EQUAL; return true;
+        case QueryOp::LESS: inverse = QueryOp::GREATER_EQUAL; return true;
+        case QueryOp::LESS_EQUAL: inverse = QueryOp::GREATER; return true;
+        case QueryOp::GREATER: inverse = QueryOp::LESS_EQUAL; return true;
+        case QueryOp::GREATER_EQUAL: inverse = QueryOp::LESS; return true;
+        default: return false;
+    }
+}
+
+// Simplifies the tree bottom-up: not of a constant or of a negation, not
+// pushed into an invertible comparison, nested AND/OR flattened, identity
+// and absorbing constants, repeated terms, x and not x, and AND terms that
+// cannot hold together (age > 30 and age < 20, dept=SE and dept=CS).
+void QueryCompiler::fold(QueryNode& node) {
+    if (node.kind == QueryNode::Kind::COMPARE || node.kind == QueryNode::Kind::CONSTANT) {
+        return;
+    }
+    
+    for (QueryNode& child : node.children) {
+        fold(child);
+    }
+    
+    if (node.kind == QueryNode::Kind::NOT) {
+        QueryNode& child = node.children[0];
+        QueryOp inverse;
+        if (child.kind == QueryNode::Kind::CONSTANT) {
+            node = QueryNode::constant(!child.value);
+        } else if (child.kind == QueryNode::Kind::NOT) {
+            QueryNode inner = move(child.children[0]);
+            node = move(inner);
+        } else if (child.kind == QueryNode::Kind::COMPARE && !isCourseField(child.field) &&
+                   invert(child.op, inverse)) {
+            // Course predicates are false without the course, so negating
+            // one is not the same as inverting its operator.
+            QueryNode inverted = move(child);
+            inverted.op = inverse;
+            node = move(inverted);
+        }
+        return;
+    }
+    
+    bool isAnd = node.kind == QueryNode::Kind::AND;
+    vector<QueryNode> terms;
+    vector<string> seen;
+    for (QueryNode& child : node.children) {
+        if (child.kind == node.kind) {
+            for (QueryNode& grandchild : child.children) {
+                terms.push_back(move(grandchild));
+            }
+        } else {
+            terms.push_back(move(child));
+        }
+    }
+    
+    vector<QueryNode> kept;
+    for (QueryNode& term : terms) {
+        if (term.kind == QueryNode::Kind::CONSTANT) {
+            if (term.value != isAnd) {
+                node = QueryNode::constant(!isAnd);
+                return;
+            }
+            continue;
+        }
+        string key = term.toString();
+        if (find(seen.begin(), seen.end(), key) == seen.end()) {
+            seen.push_back(key);
+            kept.push_back(move(term));
+        }
+    }
+    
+    // x and not x, x or not x; the not may already be folded into x's operator.
+    for (const QueryNode& term : kept) {
+        string negated;
+        QueryOp inverse;
+        if (term.kind == QueryNode::Kind::NOT) {
+            negated = term.children[0].toString();
+        } else if (term.kind == QueryNode::Kind::COMPARE && !isCourseField(term.field) &&
+                   invert(term.op, inverse)) {
+            QueryNode inverted = term;
+            inverted.op = inverse;
+            negated = inverted.toString();
+        }
+        if (!negated.empty() && find(seen.begin(), seen.end(), negated) != seen.end()) {
+            node = QueryNode::constant(!isAnd);
+            return;
+        }
+    }
+    
+    if (isAnd && contradicts(kept)) {
+        node = QueryNode::constant(false);
+        return;
+    }
+    
+    if (kept.empty()) {
+        node = QueryNode::constant(isAnd);
+    } else if (kept.size() == 1) {
+        QueryNode only = move(kept[0]);
+        node = move(only);
+    } else {
+        node.children = move(kept);
+    }
+}
+
+// Whether some field is pinned by AND terms that no single value can meet.
+bool QueryCompiler::contradicts(const vector<QueryNode>& terms) {
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const QueryNode& a = terms[i];
+        if (a.kind != QueryNode::Kind::COMPARE) continue;
+        
+        // Text: two different required values, or a required and excluded one.
+        if (!isNumeric(a.field)) {
+            if (a.op != QueryOp::EQUAL) continue;
+            for (const QueryNode& b : terms) {
+                if (b.kind == QueryNode::Kind::COMPARE && b.field == a.field &&
+                    ((b.op == QueryOp::EQUAL && b.text != a.text) ||
+                     (b.op == QueryOp::NOT_EQUAL && b.text == a.text))) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        
+        // Numbers: intersect the bounds of every term on the same field.
+        double low = -numeric_limits<double>::infinity();
+        double high = numeric_limits<double>::infinity();
+        bool lowOpen = false;
+        bool highOpen = false;
+        auto raise = [&](double v, bool open) {
+            if (v > low || (v == low && open)) { low = v; lowOpen = open; }
+        };
+        auto lower = [&](double v, bool open) {
+            if (v < high || (v == high && open)) { high = v; highOpen = open; }
+        };
+        
+        for (const QueryNode& b : terms) {
+            if (b.kind != QueryNode::Kind::COMPARE || b.field != a.field || b.course != a.course) {
+                continue;
+            }
+            switch (b.op) {
+                case QueryOp::EQUAL: raise(b.number, false); lower(b.number, false); break;
+                case QueryOp::GREATER: raise(b.number, true); break;
+                case QueryOp::GREATER_EQUAL: raise(b.number, false); break;
+                case QueryOp::LESS: lower(b.number, true); break;
+                case QueryOp::LESS_EQUAL: lower(b.number, false); break;
+                default: break;
+            }
+        }
+        if (low > high || (low == high && (lowOpen || highOpen))) {
+            return true;
+        }
+        
+        // A pinned value that is also excluded.
+        if (low == high) {
+            for (const QueryNode& b : terms) {
+                if (b.kind == QueryNode::Kind::COMPARE && b.field == a.field && b.course == a.course &&
+                    b.op == QueryOp::NOT_EQUAL && b.number == low) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+template <typename Store>
+void QueryCompiler::optimize(QueryNode& root, const Store& store, const StudentIndex& index) {
+    switch (root.kind) {
+        case QueryNode::Kind::CONSTANT:
+            root.selectivity = root.value ? 1 : 0;
+            root.cost = 0;
+            return;
+        
+        case QueryNode::Kind::COMPARE:
+            root.selectivity = max(0.0, min(1.0, estimate(root, store, index)));
+            root.cost = leafCost(root);
+            return;
+        
+        case QueryNode::Kind::NOT:
+            optimize(root.children[0], store, index);
+            root.selectivity = 1 - root.children[0].selectivity;
+            root.cost = root.children[0].cost;
+            return;
+        
+        default:
+            break;
+    }
+    
+    for (QueryNode& child : root.children) {
+        optimize(child, store, index);
+    }
+    
+    // With independent terms, AND is cheapest when it runs the terms in order
+    // of cost per chance of rejecting the student, and OR in order of cost
+    // per chance of accepting.
+    bool isAnd = root.kind == QueryNode::Kind::AND;
+    auto rank = [isAnd](const QueryNode& node) {
+        double decisive = isAnd ? 1 - node.selectivity : node.selectivity;
+        return decisive <= 0 ? numeric_limits<double>::infinity() : node.cost / decisive;
+    };
+    stable_sort(root.children.begin(), root.children.end(),
+                [&](const QueryNode& a, const QueryNode& b) { return rank(a) < rank(b); });
+    
+    double reached = 1;     // chance that evaluation gets to the next term
+    root.cost = 0;
+    for (const QueryNode& child : root.children) {
+        root.cost += reached * child.cost;
+        reached *= isAnd ? child.selectivity : 1 - child.selectivity;
+    }
+    root.selectivity = isAnd ? reached : 1 - reached;
+}
+
+template <typename Store>
+double QueryCompiler::estimate(const QueryNode& node, const Store& store, const StudentIndex& index) {
+    double total = max<size_t>(1, store.size());
+    SearchCriteria criteria;
+    bool negated = node.op == QueryOp::NOT_EQUAL;
+    
+    switch (node.field) {
+        case QueryField::ID:
+            if (node.op == QueryOp::EQUAL || negated) {
+                criteria.id = node.text;
+                double rows = QueryPlanner::estimateRows(SearchField::ID, criteria, store, index);
+                return negated ? 1 - rows / total : rows / total;
+            }
+            if (node.op == QueryOp::PREFIX) {
+                criteria.idPrefix = node.text;
+                return QueryPlanner::estimateRows(SearchField::ID_PREFIX, criteria, store, index) / total;
+            }
+            if (node.op == QueryOp::CONTAINS) {
+                return 0.1;
+            }
+            if (node.op == QueryOp::LESS || node.op == QueryOp::LESS_EQUAL) {
+                criteria.idTo = node.text;
+            } else {
+                criteria.idFrom = node.text;
+            }
+            return QueryPlanner::estimateRows(SearchField::ID_RANGE, criteria, store, index) / total;
+        
+        case QueryField::FIRST_NAME:
+        case QueryField::LAST_NAME: {
+            bool first = node.field == QueryField::FIRST_NAME;
+            (first ? criteria.firstName : criteria.lastName) = node.text;
+            double share = QueryPlanner::estimateRows(first ? SearchField::FIRST_NAME : SearchField::LAST_NAME,
+                                                      criteria, store, index) / total;
+            return negated ? 1 - share : share;
+        }
+        
+        case QueryField::DEPARTMENT:
+        case QueryField::SECTION: {
+            if (node.op != QueryOp::EQUAL && !negated) {
+                return 0.2;
+            }
+            bool department = node.field == QueryField::DEPARTMENT;
+            double rows = department ? index.withDepartment(node.text).size() : index.withSection(node.text).size();
+            return negated ? 1 - rows / total : rows / total;
+        }
+        
+        case QueryField::YEAR_OF_STUDY: {
+            // One posting list per year, so any comparison can be counted.
+            double rows = 0;
+            Student student;
+            for (int year = 1; year <= 7; ++year) {
+                student.setYearOfStudy(year);
+                if (node.matches(student)) {
+                    rows += index.withYear(year).size();
+                }
+            }
+            return rows / total;
+        }
+        
+        case QueryField::GPA: {
+            double rows;
+            switch (node.op) {
+                case QueryOp::LESS:
+                case QueryOp::LESS_EQUAL: rows = index.estimateGpaRange(-1, node.number); break;
+                case QueryOp::GREATER:
+                case QueryOp::GREATER_EQUAL: rows = index.estimateGpaRange(node.number, -1); break;
+                default: rows = index.estimateGpaRange(node.number, node.number); break;
+            }
+            return negated ? 1 - rows / total : rows / total;
+        }
+        
+        case QueryField::SEX:
+            return 0.5;
+        
+        // No statistics for these; rough guesses for a typical roster.
+        case QueryField::AGE:
+            return node.op == QueryOp::EQUAL ? 0.1 : (negated ? 0.9 : 0.5);
+        
+        default:
+            return node.op == QueryOp::EQUAL ? 0.1 : 0.3;
+    }
+}
+
+// Relative cost of one comparison: numbers are cheapest, text needs a string
+// compare or search, and course results need a map lookup first.
+double QueryCompiler::leafCost(const QueryNode& node) {
+    if (isCourseField(node.field)) {
+        return 6.0;
+    }
+    if (node.op == QueryOp::CONTAINS) {
+        return 4.0;
+    }
+    if (node.field == QueryField::DEPARTMENT || node.field == QueryField::SECTION ||
+        node.field == QueryField::SEX) {
+        return 2.0;     // copies the field
+    }
+    return isNumeric(node.field) ? 1.0 : 1.5;
+}
+
+SearchCriteria QueryCompiler::pushdownCriteria(const QueryNode& root) {
+    SearchCriteria criteria;
+    vector<const QueryNode*> terms;
+    if (root.kind == QueryNode::Kind::AND) {
+        for (const QueryNode& child : root.children) terms.push_back(&child);
+    } else {
+        terms.push_back(&root);
+    }
+    
+    // Only terms that imply the criterion are taken, and only the first one
+    // for each criterion, so the criteria never reject a match.
+    for (const QueryNode* term : terms) {
+        if (term->kind != QueryNode::Kind::COMPARE) continue;
+        const string& text = term->text;
+        QueryOp op = term->op;
+        bool lower = op == QueryOp::GREATER || op == QueryOp::GREATER_EQUAL || op == QueryOp::EQUAL;
+        bool upper = op == QueryOp::LESS || op == QueryOp::LESS_EQUAL || op == QueryOp::EQUAL;
+        
+        switch (term->field) {
+            case QueryField::ID:
+                if (op == QueryOp::EQUAL && criteria.id.empty()) criteria.id = text;
+                if (op == QueryOp::PREFIX && criteria.idPrefix.empty()) criteria.idPrefix = text;
+                if (op != QueryOp::EQUAL && lower && criteria.idFrom.empty()) criteria.idFrom = text;
+                if (op != QueryOp::EQUAL && upper && criteria.idTo.empty()) criteria.idTo = text;
+                break;
+            case QueryField::FIRST_NAME:
+                if (op == QueryOp::EQUAL || op == QueryOp::PREFIX || op == QueryOp::CONTAINS) {
+                    if (criteria.firstName.empty()) criteria.firstName = text;
+                }
+                break;
+            case QueryField::LAST_NAME:
+                if (op == QueryOp::EQUAL || op == QueryOp::PREFIX || op == QueryOp::CONTAINS) {
+                    if (criteria.lastName.empty()) criteria.lastName = text;
+                }
+                break;
+            case QueryField::DEPARTMENT:
+                if (op == QueryOp::EQUAL && criteria.department.empty()) criteria.department = text;
+                break;
+            case QueryField::SECTION:
+                if (op == QueryOp::EQUAL && criteria.section.empty()) criteria.section = text;
+                break;
+            case QueryField::YEAR_OF_STUDY:
+                if (op == QueryOp::EQUAL && criteria.yearOfStudy == -1 &&
+                    term->number == static_cast<int>(term->number)) {
+                    criteria.yearOfStudy = static_cast<int>(term->number);
+                }
+                break;
+            case QueryField::AGE:
+                if (op == QueryOp::EQUAL && criteria.age == -1 && term->number == static_cast<int>(term->number)) {
+                    criteria.age = static_cast<int>(term->number);
+                }
+                break;
+            case QueryField::GPA:
+                // -1 means "no bound" in SearchCriteria.
+                if (lower && criteria.minGPA == -1.0 && term->number >= 0) criteria.minGPA = term->number;
+                if (upper && criteria.maxGPA == -1.0 && term->number >= 0) criteria.maxGPA = term->number;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    return criteria;
+}
+
+string QueryCompiler::explain(const QueryNode& root) {
+    stringstream out;
+    explainNode(root, 0, out);
+    return out.str();
+}
+
+void QueryCompiler::explainNode(const QueryNode& node, int depth, stringstream& out) {
+    out << string(depth * 2, ' ');
+    if (node.kind == QueryNode::Kind::AND || node.kind == QueryNode::Kind::OR ||
+        node.kind == QueryNode::Kind::NOT) {
+        out << (node.kind == QueryNode::Kind::AND ? "and" : node.kind == QueryNode::Kind::OR ? "or" : "not");
+    } else {
+        out << node.toString();
+    }
+    out << fixed << setprecision(1) << " (" << node.selectivity * 100 << "%, cost "
+        << node.cost << ")" << endl;
+    
+    for (const QueryNode& child : node.children) {
+        explainNode(child, depth + 1, out);
+    }
+}
+
+string QueryCompiler::fieldName(QueryField field) {
+    switch (field) {
+        case QueryField::ID: return "id";
+        case QueryField::FIRST_NAME: return "first";
+        case QueryField::LAST_NAME: return "last";
+        case QueryField::DEPARTMENT: return "dept";
+        case QueryField::SECTION: return "section";
+        case QueryField::AGE: return "age";
+        case QueryField::SEX: return "sex";
+        case QueryField::YEAR_OF_STUDY: return "year";
+        case QueryField::GPA: return "gpa";
+        case QueryField::COURSE_GRADE: return "grade";
+        case QueryField::COURSE_SCORE: return "score";
+        case QueryField::COURSE_ASSESSMENT: return "assessment";
+        case QueryField::COURSE_FINAL: return "final";
+    }
+    return "";
+}
+
+string QueryCompiler::opName(QueryOp op) {
+    switch (op) {
+        case QueryOp::EQUAL: return "=";
+        case QueryOp::NOT_EQUAL: return "!=";
+        case QueryOp::LESS: return "<";
+        case QueryOp::LESS_EQUAL: return "<=";
+        case QueryOp::GREATER: return ">";
+        case QueryOp::GREATER_EQUAL: return ">=";
+        case QueryOp::CONTAINS: return "~";
+        case QueryOp::PREFIX: return "=";
+    }
+    return "";
+}
@@ -0,0 +1,501 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+// Where a plan takes its candidate rows from.
+enum class AccessPath {
+    FULL_SCAN,
+    ID_LOOKUP,
+    ID_PREFIX,
+    ID_RANGE,
+    COHORT,
+    DEPARTMENT,
+    SECTION,
+    YEAR_OF_STUDY,
+    GPA_RANGE,
+    FIRST_NAME,     // trigram candidates; the name check still runs
+    LAST_NAME,
+    INDEX_UNION,    // MATCH_ANY: one index scan per criterion, merged
+    BITMAP,         // AND/OR of the categorical row bitmaps
+    COLUMN_SCAN     // SIMD filter over the columnar copy of the numeric fields
+};
+
+struct PlannedField {
+    SearchField field;
+    double selectivity;     // estimated fraction of the roster that passes
+};
+
+// Execution plan for one search: the access path that produces candidates,
+// and the remaining checks in the order they run.
+struct QueryPlan {
+    SearchCriteria criteria;
+    SearchMode mode;
+    AccessPath access;
+    vector<AccessPath> unionPaths;      // only for INDEX_UNION
+    vector<PlannedField> filters;       // empty when the access path is exact
+    vector<SearchField> filterOrder;    // the fields of `filters`
+    int rosterSize;
+    double estimatedRows;
+    int rowLimit;                       // -1 when every match is wanted
+    
+    QueryPlan() : mode(SearchMode::MATCH_ALL), access(AccessPath::FULL_SCAN),
+                  rosterSize(0), estimatedRows(0), rowLimit(-1) {}
+    
+    bool matches(const Student& student) const;
+    string describe() const;
+};
+
+// Counters filled in while a plan runs, for explain().
+struct QueryStats {
+    int rowsExamined;
+    int rowsMatched;
+    
+    QueryStats() : rowsExamined(0), rowsMatched(0) {}
+};
+
+// Turns SearchCriteria into a QueryPlan using the sizes of the primary store
+// and the secondary indexes as statistics.
+class QueryPlanner {
+public:
+    // With a rowLimit, only the first rowLimit matches are wanted, so a path
+    // that streams rows in ID order is charged for the part it reads before
+    // the limit is reached.
+    template <typename Store>
+    static QueryPlan plan(const SearchCriteria& criteria, SearchMode mode,
+                          const Store& store, const StudentIndex& index, int rowLimit = -1);
+    
+    static string accessPathName(AccessPath path);
+    static string fieldName(SearchField field);
+    
+    // Whether a path yields candidates in ID order, and whether every one of
+    // them is known to meet the criterion (trigram candidates are not).
+    static bool yieldsIdOrder(AccessPath path);
+    static bool isExact(AccessPath path);
+    
+    // Whether a path is walked in place, so it can stop at a row limit;
+    // the others gather every candidate first.
+    static bool streams(AccessPath path);
+    
+    // Estimated number of students meeting one criterion, from the index
+    // sizes; QueryCompiler uses it for its predicates too.
+    template <typename Store>
+    static double estimateRows(SearchField field, const SearchCriteria& criteria,
+                               const Store& store, const StudentIndex& index);
+
+private:
+    // Index candidates are reached through pointers and may need sorting back
+    // into ID order, so a row from a secondary index costs about this many
+    // rows of sequential store scan.
+    static constexpr double INDEX_ROW_COST = 2.0;
+    
+    // A column scan compares 32 rows per instruction over a few bytes each,
+    // so it costs a small fraction of a record scan per roster row, plus the
+    // rows it returns.
+    static constexpr double COLUMN_ROW_COST = 0.05;
+    
+    // Combining bitmaps touches one 64-row word per criterion at worst.
+    static constexpr double BITMAP_ROW_COST = 1.0 / 64;
+    
+    template <typename Store>
+    static int countIdRange(const Store& store, const string& from, const string& to);
+    
+    static AccessPath indexFor(SearchField field, const SearchCriteria& criteria);
+    static bool isAnsweredBy(AccessPath path, SearchField field, const SearchCriteria& criteria,
+                             const StudentIndex& index);
+    static bool isCoveredBy(AccessPath path, SearchField field, const SearchCriteria& criteria);
+    static double checkCost(SearchField field);
+};
+
+
+bool QueryPlan::matches(const Student& student) const {
+    // With no checks left, every candidate came from an access path that
+    // already applied the criteria.
+    if (filterOrder.empty() && access != AccessPath::FULL_SCAN) {
+        return true;
+    }
+    return SearchManager::matchesFields(student, criteria, filterOrder, mode);
+}
+
+string QueryPlan::describe() const {
+    stringstream out;
+    out << fixed << setprecision(1);
+    
+    out << "Access: " << QueryPlanner::accessPathName(access);
+    for (size_t i = 0; i < unionPaths.size(); ++i) {
+        out << (i == 0 ? " of " : " + ") << QueryPlanner::accessPathName(unionPaths[i]);
+    }
+    out << endl;
+    
+    if (!filters.empty()) {
+        out << "Filter (" << (mode == SearchMode::MATCH_ALL ? "AND, stop at first failure"
+                                                            : "OR, stop at first match") << "): ";
+        for (size_t i = 0; i < filters.size(); ++i) {
+            out << (i == 0 ? "" : ", ") << QueryPlanner::fieldName(filters[i].field)
+                << " (" << filters[i].selectivity * 100 << "%)";
+        }
+        out << endl;
+    }
+    
+    out << setprecision(0) << "Estimated matches: " << estimatedRows << " of " << rosterSize << endl;
+    if (rowLimit >= 0) {
+        out << "Row limit: " << rowLimit << endl;
+    }
+    return out.str();
+}
+
+template <typename Store>
+QueryPlan QueryPlanner::plan(const SearchCriteria& criteria, SearchMode mode,
+                             const Store& store, const StudentIndex& index, int rowLimit) {
+    QueryPlan result;
+    result.criteria = criteria;
+    result.mode = mode;
+    result.rosterSize = store.size();
+    result.rowLimit = rowLimit;
+    
+    double total = max(1, result.rosterSize);
+    vector<SearchField> fields = SearchManager::activeFields(criteria);
+    vector<double> rows;
+    for (SearchField field : fields) {
+        rows.push_back(estimateRows(field, criteria, store, index));
+    }
+    
+    // Share of a streaming path read before rowLimit matches turn up,
+    // assuming matches are spread evenly through the roster. OR matches at
+    // least as many rows as its broadest criterion.
+    double streamedShare = 1;
+    if (rowLimit >= 0) {
+        double expectedMatches = mode == SearchMode::MATCH_ALL ? total : 0;
+        for (double fieldRows : rows) {
+            expectedMatches = mode == SearchMode::MATCH_ALL
+                ? expectedMatches * fieldRows / total : max(expectedMatches, fieldRows);
+        }
+        streamedShare = min(1.0, (rowLimit + 1) / max(1.0, expectedMatches));
+    }
+    
+    if (mode == SearchMode::MATCH_ALL) {
+        // Cheapest single access path; a full scan costs one unit per row.
+        double bestCost = total * streamedShare;
+        double bestRows = total;
+        
+        bool hasCohort = !criteria.department.empty() && criteria.yearOfStudy != -1 &&
+                         !criteria.section.empty();
+        if (hasCohort) {
+            double cohortRows = index.withCohort(criteria.department, criteria.yearOfStudy,
+                                                 criteria.section).size();
+            double cohortCost = cohortRows * INDEX_ROW_COST * streamedShare;
+            if (cohortCost < bestCost) {
+                result.access = AccessPath::COHORT;
+                bestCost = cohortCost;
+                bestRows = cohortRows;
+            }
+        }
+        
+        for (size_t i = 0; i < fields.size(); ++i) {
+            AccessPath path = indexFor(fields[i], criteria);
+            if (path == AccessPath::FULL_SCAN) continue;
+            
+            bool primary = path == AccessPath::ID_LOOKUP || path == AccessPath::ID_PREFIX ||
+                           path == AccessPath::ID_RANGE;
+            double cost = rows[i] * (primary ? 1.0 : INDEX_ROW_COST) *
+                          (streams(path) ? streamedShare : 1.0);
+            if (cost < bestCost) {
+                result.access = path;
+                bestCost = cost;
+                bestRows = rows[i];
+            }
+        }
+        
+        // The bitmaps answer every categorical criterion at once.
+        int categorical = 0;
+        double bitmapRows = total;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (StudentColumns::isCategorical(fields[i])) {
+                categorical++;
+                bitmapRows *= rows[i] / total;
+            }
+        }
+        double bitmapCost = categorical * total * BITMAP_ROW_COST + bitmapRows;
+        if (categorical > 0 && bitmapCost < bestCost) {
+            result.access = AccessPath::BITMAP;
+            bestCost = bitmapCost;
+            bestRows = bitmapRows;
+        }
+        
+        // A column scan applies every numeric criterion at once.
+        bool anyColumnar = false;
+        double columnRows = total;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (StudentColumns::isColumnar(fields[i])) {
+                anyColumnar = true;
+                columnRows *= rows[i] / total;
+            }
+        }
+        if (anyColumnar && total * COLUMN_ROW_COST + columnRows < bestCost) {
+            result.access = AccessPath::COLUMN_SCAN;
+            bestCost = total * COLUMN_ROW_COST + columnRows;
+            bestRows = columnRows;
+        }
+        
+        // Checks the access path already guarantees are dropped; the rest run
+        // in the order most likely to reject a row for the least work.
+        result.estimatedRows = bestRows;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (isAnsweredBy(result.access, fields[i], criteria, index)) continue;
+            double selectivity = rows[i] / total;
+            result.filters.push_back({fields[i], selectivity});
+            
+            // An inexact path's own estimate already covers its field.
+            if (!isCoveredBy(result.access, fields[i], criteria)) {
+                result.estimatedRows *= selectivity;
+            }
+        }
+        
+        sort(result.filters.begin(), result.filters.end(),
+             [](const PlannedField& a, const PlannedField& b) {
+                 return (1 - a.selectivity) / checkCost(a.field) >
+                        (1 - b.selectivity) / checkCost(b.field);
+             });
+    } else {
+        // A union of index scans only pays off when every criterion has an
+        // index and together they still touch less than the whole roster; a
+        // column scan, when every criterion is a numeric field.
+        double unionCost = 0;
+        double missRate = 1;
+        bool allIndexed = true;
+        bool allExact = true;
+        bool allColumnar = !fields.empty();
+        bool allColumnsExact = true;
+        bool allCategorical = !fields.empty();
+        
+        for (size_t i = 0; i < fields.size(); ++i) {
+            AccessPath path = indexFor(fields[i], criteria);
+            allIndexed = allIndexed && path != AccessPath::FULL_SCAN;
+            allExact = allExact && isExact(path);
+            allColumnar = allColumnar && StudentColumns::isColumnar(fields[i]);
+            allCategorical = allCategorical && StudentColumns::isCategorical(fields[i]);
+            allColumnsExact = allColumnsExact && index.columns().isExact(fields[i], criteria);
+            unionCost += rows[i] * INDEX_ROW_COST;
+            missRate *= 1 - rows[i] / total;
+            result.filters.push_back({fields[i], rows[i] / total});
+        }
+        result.estimatedRows = fields.empty() ? 0 : total * (1 - missRate);
+        
+        double bestCost = total * streamedShare;
+        if (allIndexed && unionCost < bestCost) {
+            result.access = AccessPath::INDEX_UNION;
+            bestCost = unionCost;
+            for (SearchField field : fields) {
+                result.unionPaths.push_back(indexFor(field, criteria));
+            }
+        }
+        
+        double bitmapCost = fields.size() * total * BITMAP_ROW_COST + result.estimatedRows;
+        if (allCategorical && bitmapCost < bestCost) {
+            result.access = AccessPath::BITMAP;
+            bestCost = bitmapCost;
+            result.unionPaths.clear();
+        }
+        
+        if (allColumnar && total * COLUMN_ROW_COST + result.estimatedRows < bestCost) {
+            result.access = AccessPath::COLUMN_SCAN;
+            result.unionPaths.clear();
+        }
+        
+        if ((result.access == AccessPath::INDEX_UNION && allExact) ||
+            result.access == AccessPath::BITMAP ||
+            (result.access == AccessPath::COLUMN_SCAN && allColumnsExact)) {
+            result.filters.clear();
+        } else {
+            sort(result.filters.begin(), result.filters.end(),
+                 [](const PlannedField& a, const PlannedField& b) {
+                     return a.selectivity / checkCost(a.field) >
+                            b.selectivity / checkCost(b.field);
+                 });
+        }
+    }
+    
+    for (const PlannedField& filter : result.filters) {
+        result.filterOrder.push_back(filter.field);
+    }
+    
+    return result;
+}
+
+template <typename Store>
+double QueryPlanner::estimateRows(SearchField field, const SearchCriteria& criteria,
+                                  const Store& store, const StudentIndex& index) {
+    double total = store.size();
+    
+    switch (field) {
+        case SearchField::ID:
+            return store.find(criteria.id) ? 1 : 0;
+        
+        case SearchField::ID_PREFIX: {
+            // Every ID with the prefix sorts below the prefix with its last
+            // character incremented.
+            string upper = criteria.idPrefix;
+            while (!upper.empty() && static_cast<unsigned char>(upper.back()) == 0xFF) {
+                upper.pop_back();
+            }
+            if (upper.empty()) {
+                return total - store.rank(criteria.idPrefix);
+            }
+            upper.back()++;
+            return store.rank(upper) - store.rank(criteria.idPrefix);
+        }
+        
+        case SearchField::ID_RANGE:
+            return countIdRange(store, criteria.idFrom, criteria.idTo);
+        
+        case SearchField::DEPARTMENT:
+            return index.withDepartment(criteria.department).size();
+        
+        case SearchField::SECTION:
+            return index.withSection(criteria.section).size();
+        
+        case SearchField::YEAR_OF_STUDY:
+            return index.withYear(criteria.yearOfStudy).size();
+        
+        case SearchField::GPA_RANGE:
+            return index.estimateGpaRange(criteria.minGPA, criteria.maxGPA);
+        
+        case SearchField::SEX:
+            return total / 2;
+        
+        case SearchField::FIRST_NAME:
+            if (criteria.firstName.size() >= TrigramIndex::MIN_QUERY_LENGTH) {
+                return index.firstNameTrigrams().estimate(criteria.firstName);
+            }
+            return total / 10;
+            
+        case SearchField::LAST_NAME:
+            if (criteria.lastName.size() >= TrigramIndex::MIN_QUERY_LENGTH) {
+                return index.lastNameTrigrams().estimate(criteria.lastName);
+            }
+            return total / 10;
+            
+        // No statistics for these; rough guesses for a typical roster.
+        case SearchField::AGE:
+            return total / 10;
+    }
+    
+    return total;
+}
+
+template <typename Store>
+int QueryPlanner::countIdRange(const Store& store, const string& from, const string& to) {
+    int low = from.empty() ? 0 : store.rank(from);
+    if (to.empty()) {
+        return store.size() - low;
+    }
+    
+    int high = store.rank(to) + (store.find(to) ? 1 : 0);
+    return max(0, high - low);
+}
+
+AccessPath QueryPlanner::indexFor(SearchField field, const SearchCriteria& criteria) {
+    switch (field) {
+        case SearchField::ID: return AccessPath::ID_LOOKUP;
+        case SearchField::ID_PREFIX: return AccessPath::ID_PREFIX;
+        case SearchField::ID_RANGE: return AccessPath::ID_RANGE;
+        case SearchField::DEPARTMENT: return AccessPath::DEPARTMENT;
+        case SearchField::SECTION: return AccessPath::SECTION;
+        case SearchField::YEAR_OF_STUDY: return AccessPath::YEAR_OF_STUDY;
+        case SearchField::GPA_RANGE: return AccessPath::GPA_RANGE;
+        case SearchField::FIRST_NAME:
+            return criteria.firstName.size() >= TrigramIndex::MIN_QUERY_LENGTH
+                ? AccessPath::FIRST_NAME : AccessPath::FULL_SCAN;
+        case SearchField::LAST_NAME:
+            return criteria.lastName.size() >= TrigramIndex::MIN_QUERY_LENGTH
+                ? AccessPath::LAST_NAME : AccessPath::FULL_SCAN;
+        default: return AccessPath::FULL_SCAN;
+    }
+}
+
+bool QueryPlanner::isAnsweredBy(AccessPath path, SearchField field, const SearchCriteria& criteria,
+                                const StudentIndex& index) {
+    if (path == AccessPath::COLUMN_SCAN) {
+        return StudentColumns::isColumnar(field) && index.columns().isExact(field, criteria);
+    }
+    if (path == AccessPath::BITMAP) {
+        return StudentColumns::isCategorical(field);
+    }
+    if (path == AccessPath::COHORT) {
+        return field == SearchField::DEPARTMENT || field == SearchField::SECTION ||
+               field == SearchField::YEAR_OF_STUDY;
+    }
+    return path != AccessPath::FULL_SCAN && isExact(path) && indexFor(field, criteria) == path;
+}
+
+// Whether the row estimate of `path` already includes `field`.
+bool QueryPlanner::isCoveredBy(AccessPath path, SearchField field, const SearchCriteria& criteria) {
+    if (path == AccessPath::COLUMN_SCAN) {
+        return StudentColumns::isColumnar(field);
+    }
+    if (path == AccessPath::BITMAP) {
+        return StudentColumns::isCategorical(field);
+    }
+    return indexFor(field, criteria) == path;
+}
+
+bool QueryPlanner::yieldsIdOrder(AccessPath path) {
+    return path != AccessPath::GPA_RANGE && path != AccessPath::FIRST_NAME &&
+           path != AccessPath::LAST_NAME && path != AccessPath::INDEX_UNION;
+}
+
+bool QueryPlanner::streams(AccessPath path) {
+    return path == AccessPath::FULL_SCAN || path == AccessPath::ID_LOOKUP ||
+           path == AccessPath::ID_PREFIX || path == AccessPath::ID_RANGE ||
+           path == AccessPath::COHORT || path == AccessPath::DEPARTMENT ||
+           path == AccessPath::SECTION || path == AccessPath::YEAR_OF_STUDY;
+}
+
+bool QueryPlanner::isExact(AccessPath path) {
+    return path != AccessPath::FIRST_NAME && path != AccessPath::LAST_NAME;
+}
+
+// Relative cost of one check; the name checks lowercase both strings.
+double QueryPlanner::checkCost(SearchField field) {
+    return field == SearchField::FIRST_NAME || field == SearchField::LAST_NAME ? 4.0 : 1.0;
+}
+
+string QueryPlanner::accessPathName(AccessPath path) {
+    switch (path) {
+        case AccessPath::FULL_SCAN: return "full scan";
+        case AccessPath::ID_LOOKUP: return "ID lookup";
+        case AccessPath::ID_PREFIX: return "ID prefix scan";
+        case AccessPath::ID_RANGE: return "ID range scan";
+        case AccessPath::COHORT: return "cohort index";
+        case AccessPath::DEPARTMENT: return "department index";
+        case AccessPath::SECTION: return "section index";
+        case AccessPath::YEAR_OF_STUDY: return "year index";
+        case AccessPath::GPA_RANGE: return "GPA index";
+        case AccessPath::FIRST_NAME: return "first-name trigram index";
+        case AccessPath::LAST_NAME: return "last-name trigram index";
+        case AccessPath::INDEX_UNION: return "index union";
+        case AccessPath::BITMAP: return "bitmap index";
+        case AccessPath::COLUMN_SCAN: return string("column scan (") + StudentColumns::kernelName() + ")";
+    }
+    return "";
+}
+
+string QueryPlanner::fieldName(SearchField field) {
+    switch (field) {
+        case SearchField::ID: return "id";
+        case SearchField::ID_PREFIX: return "id prefix";
+        case SearchField::ID_RANGE: return "id range";
+        case SearchField::FIRST_NAME: return "first name";
+        case SearchField::LAST_NAME: return "last name";
+        case SearchField::DEPARTMENT: return "department";
+        case SearchField::SECTION: return "section";
+        case SearchField::AGE: return "age";
+        case SearchField::SEX: return "sex";
+        case SearchField::YEAR_OF_STUDY: return "year";
+        case SearchField::GPA_RANGE: return "GPA";
+    }
+    return "";
+}
@@ -0,0 +1,190 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+// Compact (radix) trie over one case-folded text field, for type-ahead. Each
+// edge carries a whole run of characters, so a node either ends a key or
+// branches, and the trie has fewer nodes than twice the number of distinct
+// keys. Children are kept in character order and each node's records in an
+// ID-ordered set, so a prefix query walks down O(prefix length) nodes and
+// then visits the keys under it alphabetically, stopping after the first
+// `limit` records: every node it enters yields a record or branches towards
+// one.
+class RadixTrie {
+private:
+    struct IdLess {
+        bool operator()(const Student* a, const Student* b) const { return a->getId() < b->getId(); }
+    };
+    
+    struct Node {
+        string label;                       // characters on the edge from the parent
+        vector<unique_ptr<Node>> children;  // sorted by the first label character
+        set<const Student*, IdLess> students;   // records whose key ends here
+    };
+    
+    Node root;
+    
+    static vector<unique_ptr<Node>>::iterator childFor(Node& node, char c);
+    static vector<unique_ptr<Node>>::const_iterator childFor(const Node& node, char c);
+    
+    // Merges node.children[index] into its only child, or drops it once it
+    // holds nothing, so that the trie stays compact after a removal.
+    static void compact(Node& parent, size_t index);
+    
+    template <typename Visitor>
+    static bool visitSubtree(const Node& node, int& remaining, Visitor& visit);
+
+public:
+    void add(const Student* student, const string& foldedKey);
+    void remove(const Student* student, const string& foldedKey);
+    void clear() { root = Node(); }
+    
+    // Calls visit(const Student*) for up to `limit` records whose key starts
+    // with `prefix` (case-insensitive), in key order and then ID order.
+    // Returns how many were visited.
+    template <typename Visitor>
+    int forEachWithPrefix(const string& prefix, int limit, Visitor visit) const;
+};
+
+
+vector<unique_ptr<RadixTrie::Node>>::iterator RadixTrie::childFor(Node& node, char c) {
+    return lower_bound(node.children.begin(), node.children.end(), c,
+                       [](const unique_ptr<Node>& child, char k) { return child->label[0] < k; });
+}
+
+vector<unique_ptr<RadixTrie::Node>>::const_iterator RadixTrie::childFor(const Node& node, char c) {
+    return lower_bound(node.children.begin(), node.children.end(), c,
+                       [](const unique_ptr<Node>& child, char k) { return child->label[0] < k; });
+}
+
+void RadixTrie::add(const Student* student, const string& foldedKey) {
+    Node* node = &root;
+    size_t pos = 0;
+    
+    while (pos < foldedKey.size()) {
+        auto it = childFor(*node, foldedKey[pos]);
+        if (it == node->children.end() || (*it)->label[0] != foldedKey[pos]) {
+            unique_ptr<Node> leaf(new Node());
+            leaf->label = foldedKey.substr(pos);
+            node = node->children.insert(it, move(leaf))->get();
+            break;
+        }
+        
+        const string& label = (*it)->label;
+        size_t common = 1;
+        while (common < label.size() && pos + common < foldedKey.size() &&
+               label[common] == foldedKey[pos + common]) {
+            ++common;
+        }
+        
+        // The key leaves the edge part-way: split it at the divergence.
+        if (common < label.size()) {
+            unique_ptr<Node> middle(new Node());
+            middle->label = label.substr(0, common);
+            (*it)->label.erase(0, common);
+            middle->children.push_back(move(*it));
+            *it = move(middle);
+        }
+        
+        node = it->get();
+        pos += common;
+    }
+    
+    // Records usually arrive in ID order, so try the end first.
+    node->students.emplace_hint(node->students.end(), student);
+}
+
+void RadixTrie::compact(Node& parent, size_t index) {
+    Node& node = *parent.children[index];
+    if (!node.students.empty()) {
+        return;
+    }
+    
+    if (node.children.empty()) {
+        parent.children.erase(parent.children.begin() + index);
+    } else if (node.children.size() == 1) {
+        unique_ptr<Node> only = move(node.children[0]);
+        node.label += only->label;
+        node.children = move(only->children);
+        node.students = move(only->students);
+    }
+}
+
+void RadixTrie::remove(const Student* student, const string& foldedKey) {
+    // (parent, child index) for every edge on the way down.
+    vector<pair<Node*, size_t>> path;
+    Node* node = &root;
+    size_t pos = 0;
+    
+    while (pos < foldedKey.size()) {
+        auto it = childFor(*node, foldedKey[pos]);
+        if (it == node->children.end() ||
+            foldedKey.compare(pos, (*it)->label.size(), (*it)->label) != 0) {
+            return;
+        }
+        path.emplace_back(node, it - node->children.begin());
+        pos += (*it)->label.size();
+        node = it->get();
+    }
+    
+    auto found = node->students.find(student);
+    if (found == node->students.end() || *found != student) {
+        return;
+    }
+    node->students.erase(found);
+    
+    // Removing a leaf can leave its parent with one child and no records,
+    // so that one needs compacting too.
+    for (size_t i = path.size(); i-- > 0 && i + 2 >= path.size();) {
+        compact(*path[i].first, path[i].second);
+    }
+}
+
+template <typename Visitor>
+bool RadixTrie::visitSubtree(const Node& node, int& remaining, Visitor& visit) {
+    for (const Student* student : node.students) {
+        if (remaining == 0) {
+            return false;
+        }
+        visit(student);
+        remaining--;
+    }
+    
+    for (const unique_ptr<Node>& child : node.children) {
+        if (remaining == 0 || !visitSubtree(*child, remaining, visit)) {
+            return false;
+        }
+    }
+    return remaining != 0;
+}
+
+template <typename Visitor>
+int RadixTrie::forEachWithPrefix(const string& prefix, int limit, Visitor visit) const {
+    string folded = Utils::toLower(prefix);
+    const Node* node = &root;
+    size_t pos = 0;
+    
+    while (pos < folded.size()) {
+        auto it = childFor(*node, folded[pos]);
+        if (it == node->children.end() || (*it)->label[0] != folded[pos]) {
+            return 0;
+        }
+        
+        // The prefix may end part-way along the edge.
+        const string& label = (*it)->label;
+        size_t length = min(label.size(), folded.size() - pos);
+        if (folded.compare(pos, length, label, 0, length) != 0) {
+            return 0;
+        }
+        pos += length;
+        node = it->get();
+    }
+    
+    int remaining = limit < 0 ? -1 : limit;
+    visitSubtree(*node, remaining, visit);
+    return limit < 0 ? -1 - remaining : limit - remaining;
+}
@@ -0,0 +1,295 @@
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+
+using namespace std;
+
+// Compressed set of row numbers in the style of a roaring bitmap. Rows are
+// grouped by their high 16 bits into containers. A container holding at
+// most ARRAY_MAX rows is a sorted array of the low 16 bits; a fuller one is
+// a 65536-bit bitmap, so AND/OR of dense containers run 64 rows per word.
+class RowBitmap {
+private:
+    struct Container {
+        uint16_t key;
+        vector<uint16_t> values;    // sorted; used while the container is sparse
+        vector<uint64_t> words;     // WORDS words; used once it is dense
+        uint32_t count;
+        
+        explicit Container(uint16_t k) : key(k), count(0) {}
+        
+        bool dense() const { return !words.empty(); }
+        bool contains(uint16_t low) const;
+        void toDense();
+        void toSparse();
+    };
+    
+    static constexpr uint32_t ARRAY_MAX = 4096;
+    static constexpr size_t WORDS = 65536 / 64;
+    
+    vector<Container> containers;   // sorted by key
+    
+    vector<Container>::iterator findContainer(uint16_t key);
+    vector<Container>::const_iterator findContainer(uint16_t key) const;
+    
+    static Container intersect(const Container& a, const Container& b);
+    static Container unite(const Container& a, const Container& b);
+
+public:
+    void add(uint32_t row);
+    void remove(uint32_t row);
+    bool contains(uint32_t row) const;
+    size_t cardinality() const;
+    bool empty() const { return containers.empty(); }
+    void clear() { containers.clear(); }
+    
+    static RowBitmap intersect(const RowBitmap& a, const RowBitmap& b);
+    static RowBitmap unite(const RowBitmap& a, const RowBitmap& b);
+    
+    // Calls visit(uint32_t row) for each row in ascending order.
+    template <typename Visitor>
+    void forEach(Visitor visit) const;
+};
+
+
+bool RowBitmap::Container::contains(uint16_t low) const {
+    if (dense()) {
+        return (words[low >> 6] >> (low & 63)) & 1;
+    }
+    return binary_search(values.begin(), values.end(), low);
+}
+
+void RowBitmap::Container::toDense() {
+    words.assign(WORDS, 0);
+    for (uint16_t low : values) {
+        words[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    vector<uint16_t>().swap(values);
+}
+
+void RowBitmap::Container::toSparse() {
+    values.clear();
+    values.reserve(count);
+    for (size_t w = 0; w < WORDS; ++w) {
+        for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+            values.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(bits)));
+        }
+    }
+    vector<uint64_t>().swap(words);
+}
+
+vector<RowBitmap::Container>::iterator RowBitmap::findContainer(uint16_t key) {
+    return lower_bound(containers.begin(), containers.end(), key,
+                       [](const Container& c, uint16_t k) { return c.key < k; });
+}
+
+vector<RowBitmap::Container>::const_iterator RowBitmap::findContainer(uint16_t key) const {
+    return lower_bound(containers.begin(), containers.end(), key,
+                       [](const Container& c, uint16_t k) { return c.key < k; });
+}
+
+void RowBitmap::add(uint32_t row) {
+    uint16_t key = row >> 16;
+    uint16_t low = row & 0xFFFF;
+    
+    auto it = findContainer(key);
+    if (it == containers.end() || it->key != key) {
+        it = containers.insert(it, Container(key));
+    }
+    
+    Container& c = *it;
+    if (c.dense()) {
+        uint64_t& word = c.words[low >> 6];
+        uint64_t bit = uint64_t(1) << (low & 63);
+        c.count += (word & bit) == 0;
+        word |= bit;
+        return;
+    }
+    
+    // Rows mostly arrive in ascending order, so check the end first.
+    if (c.values.empty() || c.values.back() < low) {
+        c.values.push_back(low);
+    } else {
+        auto pos = lower_bound(c.values.begin(), c.values.end(), low);
+        if (*pos == low) {
+            return;
+        }
+        c.values.insert(pos, low);
+    }
+    
+    if (++c.count > ARRAY_MAX) {
+        c.toDense();
+    }
+}
+
+void RowBitmap::remove(uint32_t row) {
+    uint16_t key = row >> 16;
+    uint16_t low = row & 0xFFFF;
+    
+    auto it = findContainer(key);
+    if (it == containers.end() || it->key != key) {
+        return;
+    }
+    
+    Container& c = *it;
+    if (c.dense()) {
+        uint64_t& word = c.words[low >> 6];
+        uint64_t bit = uint64_t(1) << (low & 63);
+        if (!(word & bit)) {
+            return;
+        }
+        word &= ~bit;
+        // Half of ARRAY_MAX, so a container near the limit doesn't flip back
+        // and forth.
+        if (--c.count <= ARRAY_MAX / 2) {
+            c.toSparse();
+        }
+    } else {
+        auto pos = lower_bound(c.values.begin(), c.values.end(), low);
+        if (pos == c.values.end() || *pos != low) {
+            return;
+        }
+        c.values.erase(pos);
+        --c.count;
+    }
+    
+    if (c.count == 0) {
+        containers.erase(it);
+    }
+}
+
+bool RowBitmap::contains(uint32_t row) const {
+    auto it = findContainer(row >> 16);
+    return it != containers.end() && it->key == (row >> 16) && it->contains(row & 0xFFFF);
+}
+
+size_t RowBitmap::cardinality() const {
+    size_t total = 0;
+    for (const Container& c : containers) {
+        total += c.count;
+    }
+    return total;
+}
+
+RowBitmap::Container RowBitmap::intersect(const Container& a, const Container& b) {
+    Container result(a.key);
+    
+    if (a.dense() && b.dense()) {
+        result.words.resize(WORDS);
+        for (size_t w = 0; w < WORDS; ++w) {
+            result.words[w] = a.words[w] & b.words[w];
+            result.count += __builtin_popcountll(result.words[w]);
+        }
+        if (result.count <= ARRAY_MAX) {
+            result.toSparse();
+        }
+    } else if (a.dense() || b.dense()) {
+        const Container& sparse = a.dense() ? b : a;
+        const Container& dense = a.dense() ? a : b;
+        for (uint16_t low : sparse.values) {
+            if (dense.contains(low)) {
+                result.values.push_back(low);
+            }
+        }
+        result.count = result.values.size();
+    } else {
+        set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                         back_inserter(result.values));
+        result.count = result.values.size();
+    }
+    
+    return result;
+}
+
+RowBitmap::Container RowBitmap::unite(const Container& a, const Container& b) {
+    Container result(a.key);
+    
+    if (a.dense() || b.dense()) {
+        const Container& dense = a.dense() ? a : b;
+        const Container& other = a.dense() ? b : a;
+        result.words = dense.words;
+        if (other.dense()) {
+            for (size_t w = 0; w < WORDS; ++w) {
+                result.words[w] |= other.words[w];
+            }
+        } else {
+            for (uint16_t low : other.values) {
+                result.words[low >> 6] |= uint64_t(1) << (low & 63);
+            }
+        }
+        for (uint64_t word : result.words) {
+            result.count += __builtin_popcountll(word);
+        }
+    } else {
+        set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                  back_inserter(result.values));
+        result.count = result.values.size();
+        if (result.count > ARRAY_MAX) {
+            result.toDense();
+        }
+    }
+    
+    return result;
+}
+
+RowBitmap RowBitmap::intersect(const RowBitmap& a, const RowBitmap& b) {
+    RowBitmap result;
+    auto ia = a.containers.begin();
+    auto ib = b.containers.begin();
+    
+    while (ia != a.containers.end() && ib != b.containers.end()) {
+        if (ia->key < ib->key) {
+            ++ia;
+        } else if (ib->key < ia->key) {
+            ++ib;
+        } else {
+            Container c = intersect(*ia, *ib);
+            if (c.count > 0) {
+                result.containers.push_back(move(c));
+            }
+            ++ia;
+            ++ib;
+        }
+    }
+    
+    return result;
+}
+
+RowBitmap RowBitmap::unite(const RowBitmap& a, const RowBitmap& b) {
+    RowBitmap result;
+    auto ia = a.containers.begin();
+    auto ib = b.containers.begin();
+    
+    while (ia != a.containers.end() || ib != b.containers.end()) {
+        if (ib == b.containers.end() || (ia != a.containers.end() && ia->key < ib->key)) {
+            result.containers.push_back(*ia++);
+        } else if (ia == a.containers.end() || ib->key < ia->key) {
+            result.containers.push_back(*ib++);
+        } else {
+            result.containers.push_back(unite(*ia, *ib));
+            ++ia;
+            ++ib;
+        }
+    }
+    
+    return result;
+}
+
+template <typename Visitor>
+void RowBitmap::forEach(Visitor visit) const {
+    for (const Container& c : containers) {
+        uint32_t high = uint32_t(c.key) << 16;
+        if (c.dense()) {
+            for (size_t w = 0; w < WORDS; ++w) {
+                for (uint64_t bits = c.words[w]; bits; bits &= bits - 1) {
+                    visit(high | static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)));
+                }
+            }
+        } else {
+            for (uint16_t low : c.values) {
+                visit(high | low);
+            }
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <iterator>
+#include <future>
 
 using namespace std;
 
@@ -11,38 +13,119 @@ enum class SearchMode {
 
 struct SearchCriteria {
     string id;
+    string idPrefix;
+    string idFrom;      // inclusive ID range; an empty bound is open
+    string idTo;
     string firstName;
     string lastName;
     string department;
+    string section;
     int age;
     char sex;
     int yearOfStudy;
     double minGPA;
     double maxGPA;
     
-    SearchCriteria() : id(""), firstName(""), lastName(""), department(""),
-                      age(-1), sex('\0'), yearOfStudy(-1), minGPA(-1.0), maxGPA(-1.0) {}
+    SearchCriteria() : id(""), idPrefix(""), idFrom(""), idTo(""), firstName(""), lastName(""), department(""),
+                      section(""), age(-1), sex('\0'), yearOfStudy(-1), minGPA(-1.0), maxGPA(-1.0) {}
+};
+
+// One populated field of a SearchCriteria; each is checked on its own so that
+// callers can choose the order.
+enum class SearchField {
+    ID,
+    ID_PREFIX,
+    ID_RANGE,
+    FIRST_NAME,
+    LAST_NAME,
+    DEPARTMENT,
+    SECTION,
+    AGE,
+    SEX,
+    YEAR_OF_STUDY,
+    GPA_RANGE
 };
 
 class SearchManager {
 public:
-    // Multi-parameter search
-    static vector<Student> search(const vector<Student>& students,
+    // Multi-parameter search over any range of students (a vector or the
+    // student tree itself); only the matches are copied.
+    template <typename Range>
+    static vector<Student> search(const Range& students,
                                       const SearchCriteria& criteria,
                                       SearchMode mode = SearchMode::MATCH_ALL);
     
-private:
+    // Matches as pointers into `students`, in range order, skipping the first
+    // `offset` and stopping after `limit` (-1 for no limit) without scanning
+    // the rest of the range.
+    template <typename Range>
+    static vector<const Student*> findMatches(const Range& students, const SearchCriteria& criteria,
+                                             SearchMode mode = SearchMode::MATCH_ALL,
+                                             int offset = 0, int limit = -1);
+    
+    // Streams the same matches to visit(const Student&); returns how many
+    // were visited.
+    template <typename Range, typename Visitor>
+    static int forEachMatch(const Range& students, const SearchCriteria& criteria, Visitor visit,
+                            SearchMode mode = SearchMode::MATCH_ALL,
+                            int offset = 0, int limit = -1);
+    
+    // Same results as search(), with the range split into one contiguous run
+    // per pool thread. Each run collects its own matches and the runs are
+    // joined in range order, so a store's results stay in ID order. Ranges
+    // too small to be worth splitting are searched on the calling thread.
+    template <typename Range>
+    static vector<Student> parallelSearch(const Range& students, const SearchCriteria& criteria,
+                                          SearchMode mode, ThreadPool& pool);
+    
+    // parallelSearch() with any predicate over const Student&.
+    template <typename Range, typename Predicate>
+    static vector<Student> parallelFilter(const Range& students, Predicate matches,
+                                          ThreadPool& pool);
+    
     static bool matchesCriteria(const Student& student, const SearchCriteria& criteria,
                                SearchMode mode);
+    
+    // Checks `fields` in order, stopping at the first failure (MATCH_ALL) or
+    // the first success (MATCH_ANY).
+    static bool matchesFields(const Student& student, const SearchCriteria& criteria,
+                              const vector<SearchField>& fields, SearchMode mode);
+    
+    static bool matchesField(const Student& student, const SearchCriteria& criteria,
+                             SearchField field);
+    
+    // The populated fields of `criteria`, in declaration order.
+    static vector<SearchField> activeFields(const SearchCriteria& criteria);
+    
+    static bool hasIdRange(const SearchCriteria& criteria) {
+        return !criteria.idFrom.empty() || !criteria.idTo.empty();
+    }
+    
+    static bool hasGpaRange(const SearchCriteria& criteria) {
+        return criteria.minGPA != -1.0 || criteria.maxGPA != -1.0;
+    }
+    
+    // Below this many rows per thread, a partition costs more to hand off
+    // than to scan.
+    static constexpr int MIN_PARTITION_ROWS = 4096;
+
+private:
+    // Iterators to the first element of each of `parts` equal runs, plus end().
+    // Vectors are split by position; the stores jump to the k-th element by
+    // rank with select() and lower_bound(), in O(log n) per split.
+    template <typename Range>
+    static vector<typename Range::const_iterator> partitionBounds(const Range& students, int parts);
 };
 
-vector<Student> SearchManager::search(const vector<Student>& students,
+template <typename Range>
+vector<Student> SearchManager::search(const Range& students,
                                           const SearchCriteria& criteria,
                                           SearchMode mode) {
     vector<Student> results;
+    vector<SearchField> fields = activeFields(criteria);
     
     for (const Student& student : students) {
-        if (matchesCriteria(student, criteria, mode)) {
+        if (matchesFields(student, criteria, fields, mode)) {
             results.push_back(student);
         }
     }
@@ -50,91 +133,210 @@ vector<Student> SearchManager::search(const vector<Student>& students,
     return results;
 }
 
-bool SearchManager::matchesCriteria(const Student& student, const SearchCriteria& criteria,
-                                   SearchMode mode) {
-    int matchCount = 0;
-    int criteriaCount = 0;
-        if (!criteria.id.empty()) {
-        criteriaCount++;
-        if (student.getId() == criteria.id) {
-            matchCount++;
-        }
+template <typename Range>
+vector<const Student*> SearchManager::findMatches(const Range& students, const SearchCriteria& criteria,
+                                                  SearchMode mode, int offset, int limit) {
+    vector<const Student*> handles;
+    if (limit > 0) {
+        handles.reserve(limit);
     }
-    
+    forEachMatch(students, criteria, [&](const Student& student) { handles.push_back(&student); },
+                 mode, offset, limit);
+    return handles;
+}
 
-    if (!criteria.firstName.empty()) {
-        criteriaCount++;
-        string firstName = student.getFirstName();
-        string searchName = criteria.firstName;
-        transform(firstName.begin(), firstName.end(), firstName.begin(), ::tolower);
-        transform(searchName.begin(), searchName.end(), searchName.begin(), ::tolower);
-        
-        if (firstName.find(searchName) != string::npos) {
-            matchCount++;
+template <typename Range, typename Visitor>
+int SearchManager::forEachMatch(const Range& students, const SearchCriteria& criteria, Visitor visit,
+                                SearchMode mode, int offset, int limit) {
+    vector<SearchField> fields = activeFields(criteria);
+    int skipped = 0;
+    int visited = 0;
+    
+    for (const Student& student : students) {
+        if (visited == limit) {
+            break;
+        }
+        if (!matchesFields(student, criteria, fields, mode)) {
+            continue;
         }
+        if (skipped < offset) {
+            skipped++;
+            continue;
+        }
+        visit(student);
+        visited++;
     }
     
+    return visited;
+}
 
-    if (!criteria.lastName.empty()) {
-        criteriaCount++;
-        string lastName = student.getLastName();
-        string searchName = criteria.lastName;
-        transform(lastName.begin(), lastName.end(), lastName.begin(), ::tolower);
-        transform(searchName.begin(), searchName.end(), searchName.begin(), ::tolower);
-        
-        if (lastName.find(searchName) != string::npos) {
-            matchCount++;
-        }
-    }
+template <typename Range>
+vector<Student> SearchManager::parallelSearch(const Range& students, const SearchCriteria& criteria,
+                                              SearchMode mode, ThreadPool& pool) {
+    vector<SearchField> fields = activeFields(criteria);
+    return parallelFilter(students, [&](const Student& student) {
+        return matchesFields(student, criteria, fields, mode);
+    }, pool);
+}
 
-    if (!criteria.department.empty()) {
-        criteriaCount++;
-        if (student.getDepartment() == criteria.department) {
-            matchCount++;
+template <typename Range, typename Predicate>
+vector<Student> SearchManager::parallelFilter(const Range& students, Predicate matches,
+                                              ThreadPool& pool) {
+    int count = students.size();
+    int parts = min<int>(pool.size(), count / MIN_PARTITION_ROWS);
+    
+    if (parts <= 1) {
+        vector<Student> results;
+        for (const Student& student : students) {
+            if (matches(student)) {
+                results.push_back(student);
+            }
         }
+        return results;
     }
-     if (criteria.age != -1) {
-        criteriaCount++;
-        if (student.getAge() == criteria.age) {
-            matchCount++;
-        }
+    
+    auto bounds = partitionBounds(students, parts);
+    vector<future<vector<Student>>> partials;
+    partials.reserve(parts);
+    for (int part = 0; part < parts; ++part) {
+        auto first = bounds[part];
+        auto last = bounds[part + 1];
+        partials.push_back(pool.submit([first, last, &matches] {
+            vector<Student> found;
+            for (auto it = first; it != last; ++it) {
+                if (matches(*it)) {
+                    found.push_back(*it);
+                }
+            }
+            return found;
+        }));
     }
-
-    if (criteria.sex != '\0') {
-        criteriaCount++;
-        if (student.getSex() == criteria.sex) {
-            matchCount++;
-        }
+    
+    vector<vector<Student>> found;
+    found.reserve(parts);
+    size_t total = 0;
+    for (auto& partial : partials) {
+        found.push_back(partial.get());
+        total += found.back().size();
     }
+    
+    vector<Student> results;
+    results.reserve(total);
+    for (vector<Student>& run : found) {
+        move(run.begin(), run.end(), back_inserter(results));
+    }
+    return results;
+}
 
-    if (criteria.yearOfStudy != -1) {
-        criteriaCount++;
-        if (student.getYearOfStudy() == criteria.yearOfStudy) {
-            matchCount++;
+template <typename Range>
+vector<typename Range::const_iterator> SearchManager::partitionBounds(const Range& students,
+                                                                      int parts) {
+    using Iterator = typename Range::const_iterator;
+    int count = students.size();
+    
+    vector<Iterator> bounds;
+    bounds.reserve(parts + 1);
+    bounds.push_back(students.begin());
+    for (int part = 1; part < parts; ++part) {
+        int k = static_cast<int>(static_cast<long long>(count) * part / parts);
+        if constexpr (is_base_of<random_access_iterator_tag,
+                                 typename iterator_traits<Iterator>::iterator_category>::value) {
+            bounds.push_back(students.begin() + k);
+        } else {
+            bounds.push_back(students.lower_bound(*students.select(k)));
         }
     }
+    bounds.push_back(students.end());
+    return bounds;
+}
+
+bool SearchManager::matchesCriteria(const Student& student, const SearchCriteria& criteria,
+                                   SearchMode mode) {
+    return matchesFields(student, criteria, activeFields(criteria), mode);
+}
 
-    if (criteria.minGPA != -1.0 || criteria.maxGPA != -1.0) {
-        criteriaCount++;
-        double gpa = student.getGPA();
-        bool gpaMatch = true;
+bool SearchManager::matchesFields(const Student& student, const SearchCriteria& criteria,
+                                  const vector<SearchField>& fields, SearchMode mode) {
+    for (SearchField field : fields) {
+        bool matched = matchesField(student, criteria, field);
         
-        if (criteria.minGPA != -1.0 && gpa < criteria.minGPA) {
-            gpaMatch = false;
-        }
-        if (criteria.maxGPA != -1.0 && gpa > criteria.maxGPA) {
-            gpaMatch = false;
+        if (mode == SearchMode::MATCH_ALL && !matched) {
+            return false;
         }
-        
-        if (gpaMatch) {
-            matchCount++;
+        if (mode == SearchMode::MATCH_ANY && matched) {
+            return true;
         }
     }
     
+    // No criteria at all matches everyone under AND and no one under OR.
+    return mode == SearchMode::MATCH_ALL;
+}
 
-    if (mode == SearchMode::MATCH_ALL) {
-        return matchCount == criteriaCount;
-    } else {  
-        return matchCount > 0;
+vector<SearchField> SearchManager::activeFields(const SearchCriteria& criteria) {
+    vector<SearchField> fields;
+    
+    if (!criteria.id.empty()) fields.push_back(SearchField::ID);
+    if (!criteria.idPrefix.empty()) fields.push_back(SearchField::ID_PREFIX);
+    if (hasIdRange(criteria)) fields.push_back(SearchField::ID_RANGE);
+    if (!criteria.firstName.empty()) fields.push_back(SearchField::FIRST_NAME);
+    if (!criteria.lastName.empty()) fields.push_back(SearchField::LAST_NAME);
+    if (!criteria.department.empty()) fields.push_back(SearchField::DEPARTMENT);
+    if (!criteria.section.empty()) fields.push_back(SearchField::SECTION);
+    if (criteria.age != -1) fields.push_back(SearchField::AGE);
+    if (criteria.sex != '\0') fields.push_back(SearchField::SEX);
+    if (criteria.yearOfStudy != -1) fields.push_back(SearchField::YEAR_OF_STUDY);
+    if (hasGpaRange(criteria)) fields.push_back(SearchField::GPA_RANGE);
+    
+    return fields;
+}
+
+bool SearchManager::matchesField(const Student& student, const SearchCriteria& criteria,
+                                 SearchField field) {
+    switch (field) {
+        case SearchField::ID:
+            return student.getId() == criteria.id;
+            
+        case SearchField::ID_PREFIX:
+            return student.getId().compare(0, criteria.idPrefix.size(), criteria.idPrefix) == 0;
+            
+        case SearchField::ID_RANGE: {
+            const string& id = student.getId();
+            return (criteria.idFrom.empty() || id >= criteria.idFrom) &&
+                   (criteria.idTo.empty() || id <= criteria.idTo);
+        }
+        
+        case SearchField::FIRST_NAME:
+            return Utils::containsFolded(student.getFirstNameKey(), criteria.firstName);
+            
+        case SearchField::LAST_NAME:
+            return Utils::containsFolded(student.getLastNameKey(), criteria.lastName);
+        
+        case SearchField::DEPARTMENT:
+            return student.getDepartment() == criteria.department;
+            
+        case SearchField::SECTION:
+            return student.getSection() == criteria.section;
+            
+        case SearchField::AGE:
+            return student.getAge() == criteria.age;
+            
+        case SearchField::SEX:
+            return student.getSex() == criteria.sex;
+            
+        case SearchField::YEAR_OF_STUDY:
+            return student.getYearOfStudy() == criteria.yearOfStudy;
+            
+        case SearchField::GPA_RANGE: {
+            double gpa = student.getGPA();
+            if (criteria.minGPA != -1.0 && gpa < criteria.minGPA) {
+                return false;
+            }
+            if (criteria.maxGPA != -1.0 && gpa > criteria.maxGPA) {
+                return false;
+            }
+            return true;
+        }
     }
+    
+    return false;
 }
@@ -1,6 +1,16 @@
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <future>
 
 using namespace std;
 
@@ -14,44 +24,816 @@ enum class SortField {
     NAME
 };
 
+// One key of a multi-key sort chosen at run time.
+struct SortKey {
+    SortField field;
+    bool ascending;
+    
+    SortKey(SortField f, bool asc = true) : field(f), ascending(asc) {}
+    
+    bool operator==(const SortKey& other) const { return field == other.field && ascending == other.ascending; }
+};
+
+// One key of a multi-key sort fixed at compile time, for Sorter::sortBy<...>().
+template <SortField Field, bool Ascending = true>
+struct By {
+    static constexpr SortField field = Field;
+    static constexpr bool ascending = Ascending;
+};
+
+// The value each sort field compares by, extracted once per student.
+template <SortField Field> struct FieldKey;
+
+template <> struct FieldKey<SortField::SEX> {
+    typedef char Type;
+    static Type of(const Student& s) { return s.getSex(); }
+};
+
+template <> struct FieldKey<SortField::AGE> {
+    typedef int Type;
+    static Type of(const Student& s) { return s.getAge(); }
+};
+
+template <> struct FieldKey<SortField::GPA> {
+    typedef double Type;
+    static Type of(const Student& s) { return s.getGPA(); }
+};
+
+template <> struct FieldKey<SortField::DEPARTMENT> {
+    typedef string Type;
+    static Type of(const Student& s) { return s.getDepartment(); }
+};
+
+template <> struct FieldKey<SortField::YEAR_OF_STUDY> {
+    typedef int Type;
+    static Type of(const Student& s) { return s.getYearOfStudy(); }
+};
+
+template <> struct FieldKey<SortField::ID> {
+    typedef string_view Type;
+    static Type of(const Student& s) { return s.getId(); }
+};
+
+template <> struct FieldKey<SortField::NAME> {
+    typedef string Type;
+    static Type of(const Student& s) { return s.getFullName(); }
+};
+
 class Sorter {
 public:
+    // Sorts by one field, stably: students with equal keys keep their order.
+    // Sex, age, year and GPA are sorted without comparisons (counting or
+    // radix sort, linear in the roster size); ID, name and department keys
+    // are extracted once and sorted as (key, index) pairs, so comparisons
+    // never allocate. Each Student out of place is then moved once.
     static void sort(vector<Student>& students, SortField field, bool ascending = true);
     
-private:
-    static void quickSort(vector<Student>& students, int low, int high, SortField field, bool ascending);
-    static int partition(vector<Student>& students, int low, int high, SortField field, bool ascending);
+    // The sorted order as positions into `students`, without moving them.
+    static vector<int> sortedOrder(const vector<Student>& students, SortField field, bool ascending = true);
+    
+    // A sorted view: pointers into `students`, valid while it is unchanged.
+    static vector<const Student*> sortedView(const vector<Student>& students, SortField field,
+                                             bool ascending = true);
+    
+    // Multi-key stable sort: by keys[0], then by keys[1] among students equal
+    // on keys[0], and so on. Key lists with a compiled sortBy<...>() (see
+    // compiledSorts()) run that; any other list is sorted one key at a time
+    // from the last, each a stable counting or radix pass over the key's
+    // rank, so no comparison looks at a SortField.
+    static void sort(vector<Student>& students, const vector<SortKey>& keys);
+    static vector<int> sortedOrder(const vector<Student>& students, const vector<SortKey>& keys);
+    
+    // Multi-key stable sort with the keys fixed at compile time, e.g.
+    //   Sorter::sortBy<By<SortField::DEPARTMENT>, By<SortField::GPA, false>>(students);
+    // Each student's keys are extracted once into a tuple and the
+    // comparator chain over it is expanded and inlined by the compiler.
+    template <typename... Keys>
+    static void sortBy(vector<Student>& students);
+    
+    template <typename... Keys>
+    static vector<int> sortedOrderBy(const vector<Student>& students);
+    
+    // Introsort over [first, last) by `less` (a strict weak order). Median-of-
+    // three pivots (ninther on large ranges), insertion sort below
+    // INSERTION_SORT_THRESHOLD elements and heapsort once the partitions
+    // have gone 2 log n levels deep, so the worst case is O(n log n) and the
+    // stack stays O(log n). Input that is already sorted, or sorted in
+    // reverse, is handled in one O(n) pass; runs of equal keys (sex, year)
+    // are split off in one pass each. Not stable on its own.
+    template <typename Iterator, typename Less>
+    static void introSort(Iterator first, Iterator last, Less less);
+    
+    // <0, 0 or >0 as `a` sorts before, with or after `b` on `field`.
     static int compare(const Student& a, const Student& b, SortField field);
+    
+    // Worker threads for sorting large rosters: keys are extracted and
+    // sorted in one chunk per thread, then the chunks are merged pairwise,
+    // each merge split across all the threads. 0 or 1 sorts on the calling
+    // thread (the default). Sex, age, year and GPA keep their single
+    // counting/radix pass, which is already linear.
+    static void setThreadCount(int threads);
+    static int getThreadCount();
+
+private:
+    // A student's sort key and position, 24 bytes for a string view.
+    template <typename Key>
+    struct KeyedIndex {
+        Key key;
+        int index;
+    };
+    
+    static const int INSERTION_SORT_THRESHOLD = 24;
+    static const int NINTHER_THRESHOLD = 128;
+    static const int PARTIAL_INSERTION_LIMIT = 8;
+    
+    template <typename Iterator, typename Less>
+    static void introSortLoop(Iterator first, Iterator last, int depthLimit, bool leftmost, Less& less);
+    
+    template <typename Iterator, typename Less>
+    static void sort3(Iterator a, Iterator b, Iterator c, Less& less);
+    
+    template <typename Iterator, typename Less>
+    static Iterator partitionAroundPivot(Iterator first, Iterator last, Less& less, bool& alreadyPartitioned);
+    
+    template <typename Iterator, typename Less>
+    static Iterator partitionEqualToPivot(Iterator first, Iterator last, Less& less);
+    
+    template <typename Iterator, typename Less>
+    static void insertionSort(Iterator first, Iterator last, Less& less);
+    
+    template <typename Iterator, typename Less>
+    static bool partialInsertionSort(Iterator first, Iterator last, Less& less);
+    
+    template <typename Key, typename Extract>
+    static vector<int> orderByKey(const vector<Student>& students, bool ascending, Extract extract);
+    static vector<string> textKeys(const vector<Student>& students, SortField field);
+    
+    static int compareKeys(string_view a, string_view b) { return a.compare(b); }
+    
+    // A student's keys for sortBy<Keys...>() and their position.
+    template <typename... Keys>
+    struct KeyRow {
+        tuple<typename FieldKey<Keys::field>::Type...> keys;
+        int index;
+    };
+    
+    template <size_t I, typename... Keys>
+    static bool rowLess(const KeyRow<Keys...>& a, const KeyRow<Keys...>& b);
+    
+    template <typename T>
+    static int threeWay(const T& a, const T& b) { return a < b ? -1 : (b < a ? 1 : 0); }
+    static int threeWay(const string& a, const string& b) { return a.compare(b); }
+    static int threeWay(string_view a, string_view b) { return a.compare(b); }
+    
+    typedef vector<int> (*CompiledSort)(const vector<Student>&);
+    
+    // The key lists with a compiled comparator chain, with their sorts.
+    static const vector<pair<vector<SortKey>, CompiledSort>>& compiledSorts();
+    
+    static void applyOrder(vector<Student>& students, const vector<int>& order);
+    
+    // Below this many rows per thread, a chunk costs more to hand off than
+    // to sort.
+    static const int PARALLEL_SORT_MIN_ROWS = 8192;
+    
+    struct PoolSetting {
+        mutex lock;
+        shared_ptr<ThreadPool> pool;    // null: sort on the calling thread
+    };
+    
+    static PoolSetting& poolSetting();
+    static shared_ptr<ThreadPool> threadPool();
+    
+    // Runs fn(begin, end) over one slice of [0, count) per worker of `pool`,
+    // or over all of it on the calling thread when that's not worth it.
+    template <typename Fn>
+    static void forEachSlice(ThreadPool* pool, size_t count, Fn fn);
+    static int slicesFor(const ThreadPool* pool, size_t count);
+    
+    // Sorts `rows` by `less`, which must be a total order (rows carry their
+    // position as the last tie-break). Parallel when a pool is set.
+    template <typename Row, typename Less>
+    static void sortRows(vector<Row>& rows, Less less);
+    
+    template <typename Iterator, typename Less>
+    static size_t mergePathSplit(Iterator a, size_t sizeA, Iterator b, size_t sizeB, size_t diagonal, Less& less);
+    
+    // Largest key range sorted with a single counting pass; wider ranges use
+    // radix passes of RADIX_BITS bits.
+    static const uint64_t COUNTING_SORT_RANGE = 1 << 16;
+    static const int RADIX_BITS = 16;
+    
+    static bool isSmallDomain(SortField field);
+    static vector<uint64_t> orderedKeys(const vector<Student>& students, SortField field, bool ascending);
+    static vector<int> orderByKeys(const vector<uint64_t>& keys);
+    static vector<int> countingOrder(const vector<uint64_t>& keys, uint64_t minKey, uint64_t range);
+    static vector<int> radixOrder(const vector<uint64_t>& keys);
 };
 
 void Sorter::sort(vector<Student>& students, SortField field, bool ascending) {
-    if (students.empty()) return;
-    quickSort(students, 0, students.size() - 1, field, ascending);
+    applyOrder(students, sortedOrder(students, field, ascending));
+}
+
+// Moves students[order[i]] to position i.
+void Sorter::applyOrder(vector<Student>& students, const vector<int>& order) {
+    // Apply the permutation in place, one cycle at a time: each student out
+    // of place is moved once, plus one move per cycle to carry its start.
+    vector<bool> placed(students.size(), false);
+    for (size_t start = 0; start < students.size(); ++start) {
+        if (placed[start] || order[start] == static_cast<int>(start)) {
+            continue;
+        }
+        
+        Student carried = move(students[start]);
+        size_t to = start;
+        while (true) {
+            placed[to] = true;
+            size_t from = order[to];
+            if (from == start) {
+                break;
+            }
+            students[to] = move(students[from]);
+            to = from;
+        }
+        students[to] = move(carried);
+    }
+}
+
+vector<const Student*> Sorter::sortedView(const vector<Student>& students, SortField field, bool ascending) {
+    vector<const Student*> view;
+    view.reserve(students.size());
+    for (int index : sortedOrder(students, field, ascending)) {
+        view.push_back(&students[index]);
+    }
+    return view;
+}
+
+vector<int> Sorter::sortedOrder(const vector<Student>& students, SortField field, bool ascending) {
+    if (isSmallDomain(field)) {
+        return orderByKeys(orderedKeys(students, field, ascending));
+    }
+    if (field == SortField::ID) {
+        return orderByKey<string_view>(students, ascending,
+                                       [](const Student& s, int) { return string_view(s.getId()); });
+    }
+    
+    vector<string> texts = textKeys(students, field);
+    return orderByKey<string_view>(students, ascending,
+                                   [&texts](const Student&, int i) { return string_view(texts[i]); });
+}
+
+// Names and departments are returned by value, so copy them out once.
+vector<string> Sorter::textKeys(const vector<Student>& students, SortField field) {
+    vector<string> texts(students.size());
+    forEachSlice(threadPool().get(), students.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            texts[i] = field == SortField::NAME ? students[i].getFullName() : students[i].getDepartment();
+        }
+    });
+    return texts;
+}
+
+bool Sorter::isSmallDomain(SortField field) {
+    return field == SortField::SEX || field == SortField::AGE || field == SortField::YEAR_OF_STUDY ||
+           field == SortField::GPA;
+}
+
+// Each student's field as an unsigned key in the field's order, complemented
+// for descending. Text fields become their rank among the distinct values.
+vector<uint64_t> Sorter::orderedKeys(const vector<Student>& students, SortField field, bool ascending) {
+    vector<uint64_t> keys(students.size());
+    
+    if (!isSmallDomain(field)) {
+        // Rank adjacent rows by the keys they were sorted on.
+        vector<string> texts;
+        vector<string_view> views(students.size());
+        if (field == SortField::ID) {
+            for (size_t i = 0; i < students.size(); ++i) views[i] = students[i].getId();
+        } else {
+            texts = textKeys(students, field);
+            for (size_t i = 0; i < students.size(); ++i) views[i] = texts[i];
+        }
+        vector<int> order = orderByKey<string_view>(students, true,
+                                                    [&views](const Student&, int i) { return views[i]; });
+        uint64_t rank = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (i > 0 && views[order[i - 1]] != views[order[i]]) {
+                rank++;
+            }
+            keys[order[i]] = ascending ? rank : ~rank;
+        }
+        return keys;
+    }
+    
+    // GPAs computed from credit hours aren't always whole hundredths; use
+    // fixed-point hundredths only when that keeps every value exact.
+    bool hundredths = field == SortField::GPA;
+    for (size_t i = 0; i < students.size() && hundredths; ++i) {
+        double gpa = students[i].getGPA();
+        hundredths = fabs(gpa) < 1e15 && llround(gpa * 100) / 100.0 == gpa;
+    }
+    
+    for (size_t i = 0; i < students.size(); ++i) {
+        const Student& student = students[i];
+        uint64_t key;
+        if (field == SortField::GPA && !hundredths) {
+            // IEEE-754 bits ordered like the numbers: set the sign bit of
+            // positives, flip every bit of negatives.
+            double gpa = student.getGPA() == 0 ? 0.0 : student.getGPA();
+            memcpy(&key, &gpa, sizeof key);
+            key = (key >> 63) ? ~key : key | (uint64_t(1) << 63);
+        } else {
+            int64_t value;
+            switch (field) {
+                case SortField::SEX: value = student.getSex(); break;
+                case SortField::AGE: value = student.getAge(); break;
+                case SortField::YEAR_OF_STUDY: value = student.getYearOfStudy(); break;
+                default: value = llround(student.getGPA() * 100); break;
+            }
+            key = static_cast<uint64_t>(value) ^ (uint64_t(1) << 63);
+        }
+        keys[i] = ascending ? key : ~key;
+    }
+    return keys;
+}
+
+// Stable sort of positions by unsigned keys: a counting sort when the keys
+// span a small range, radix passes otherwise.
+vector<int> Sorter::orderByKeys(const vector<uint64_t>& keys) {
+    if (keys.empty()) {
+        return {};
+    }
+    auto bounds = minmax_element(keys.begin(), keys.end());
+    uint64_t range = *bounds.second - *bounds.first;
+    if (range < COUNTING_SORT_RANGE || range < keys.size()) {
+        return countingOrder(keys, *bounds.first, range + 1);
+    }
+    return radixOrder(keys);
+}
+
+// Stable counting sort of positions by keys in [minKey, minKey + range).
+vector<int> Sorter::countingOrder(const vector<uint64_t>& keys, uint64_t minKey, uint64_t range) {
+    vector<int> starts(range + 1, 0);
+    for (uint64_t key : keys) {
+        starts[key - minKey + 1]++;
+    }
+    partial_sum(starts.begin(), starts.end(), starts.begin());
+    
+    vector<int> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        order[starts[keys[i] - minKey]++] = static_cast<int>(i);
+    }
+    return order;
+}
+
+// Stable LSD radix sort of positions, RADIX_BITS per pass, least significant
+// digit first. A pass whose digit is the same for every key is skipped.
+vector<int> Sorter::radixOrder(const vector<uint64_t>& keys) {
+    const uint64_t mask = (uint64_t(1) << RADIX_BITS) - 1;
+    vector<int> order(keys.size());
+    iota(order.begin(), order.end(), 0);
+    vector<int> next(keys.size());
+    vector<int> starts(mask + 2);
+    
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        fill(starts.begin(), starts.end(), 0);
+        for (uint64_t key : keys) {
+            starts[((key >> shift) & mask) + 1]++;
+        }
+        if (find(starts.begin(), starts.end(), static_cast<int>(keys.size())) != starts.end()) {
+            continue;
+        }
+        partial_sum(starts.begin(), starts.end(), starts.begin());
+        
+        for (int index : order) {
+            next[starts[(keys[index] >> shift) & mask]++] = index;
+        }
+        order.swap(next);
+    }
+    return order;
+}
+
+void Sorter::sort(vector<Student>& students, const vector<SortKey>& keys) {
+    applyOrder(students, sortedOrder(students, keys));
+}
+
+vector<int> Sorter::sortedOrder(const vector<Student>& students, const vector<SortKey>& keys) {
+    if (keys.size() == 1) {
+        return sortedOrder(students, keys[0].field, keys[0].ascending);
+    }
+    for (const auto& compiled : compiledSorts()) {
+        if (compiled.first == keys) {
+            return compiled.second(students);
+        }
+    }
+    
+    // Least significant key first; each pass is stable, so it keeps the
+    // order of the later keys among students equal on this one.
+    vector<int> order(students.size());
+    iota(order.begin(), order.end(), 0);
+    vector<uint64_t> permuted(students.size());
+    for (auto key = keys.rbegin(); key != keys.rend(); ++key) {
+        vector<uint64_t> column = orderedKeys(students, key->field, key->ascending);
+        for (size_t i = 0; i < order.size(); ++i) {
+            permuted[i] = column[order[i]];
+        }
+        vector<int> step = orderByKeys(permuted);
+        vector<int> next(order.size());
+        for (size_t i = 0; i < step.size(); ++i) {
+            next[i] = order[step[i]];
+        }
+        order.swap(next);
+    }
+    return order;
+}
+
+const vector<pair<vector<SortKey>, Sorter::CompiledSort>>& Sorter::compiledSorts() {
+    typedef SortField F;
+    static const vector<pair<vector<SortKey>, CompiledSort>> sorts = {
+        {{F::DEPARTMENT, F::YEAR_OF_STUDY, {F::GPA, false}, F::NAME},
+         &sortedOrderBy<By<F::DEPARTMENT>, By<F::YEAR_OF_STUDY>, By<F::GPA, false>, By<F::NAME>>},
+        {{F::DEPARTMENT, F::YEAR_OF_STUDY, F::NAME},
+         &sortedOrderBy<By<F::DEPARTMENT>, By<F::YEAR_OF_STUDY>, By<F::NAME>>},
+        {{F::DEPARTMENT, {F::GPA, false}}, &sortedOrderBy<By<F::DEPARTMENT>, By<F::GPA, false>>},
+        {{F::DEPARTMENT, F::NAME}, &sortedOrderBy<By<F::DEPARTMENT>, By<F::NAME>>},
+        {{F::YEAR_OF_STUDY, {F::GPA, false}}, &sortedOrderBy<By<F::YEAR_OF_STUDY>, By<F::GPA, false>>},
+        {{{F::GPA, false}, F::NAME}, &sortedOrderBy<By<F::GPA, false>, By<F::NAME>>}
+    };
+    return sorts;
+}
+
+template <typename... Keys>
+void Sorter::sortBy(vector<Student>& students) {
+    applyOrder(students, sortedOrderBy<Keys...>(students));
 }
 
-void Sorter::quickSort(vector<Student>& students, int low, int high, SortField field, bool ascending) {
-    if (low < high) {
-        int pi = partition(students, low, high, field, ascending);
-        quickSort(students, low, pi - 1, field, ascending);
-        quickSort(students, pi + 1, high, field, ascending);
+template <typename... Keys>
+vector<int> Sorter::sortedOrderBy(const vector<Student>& students) {
+    vector<KeyRow<Keys...>> rows(students.size());
+    forEachSlice(threadPool().get(), students.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            rows[i] = {make_tuple(FieldKey<Keys::field>::of(students[i])...), static_cast<int>(i)};
+        }
+    });
+    
+    sortRows(rows, [](const KeyRow<Keys...>& a, const KeyRow<Keys...>& b) {
+        return rowLess<0>(a, b);
+    });
+    
+    vector<int> order;
+    order.reserve(rows.size());
+    for (const KeyRow<Keys...>& row : rows) {
+        order.push_back(row.index);
+    }
+    return order;
+}
+
+// Compares key I, and the later keys only on a tie; the last tie-break is
+// the position, which keeps the sort stable.
+template <size_t I, typename... Keys>
+bool Sorter::rowLess(const KeyRow<Keys...>& a, const KeyRow<Keys...>& b) {
+    if constexpr (I == sizeof...(Keys)) {
+        return a.index < b.index;
+    } else {
+        int order = threeWay(get<I>(a.keys), get<I>(b.keys));
+        if (order != 0) {
+            return tuple_element_t<I, tuple<Keys...>>::ascending ? order < 0 : order > 0;
+        }
+        return rowLess<I + 1, Keys...>(a, b);
     }
 }
 
-int Sorter::partition(vector<Student>& students, int low, int high, SortField field, bool ascending) {
-    Student pivot = students[high];
-    int i = low - 1;
+// Ties are broken by position, which makes the order stable.
+template <typename Key, typename Extract>
+vector<int> Sorter::orderByKey(const vector<Student>& students, bool ascending, Extract extract) {
+    vector<KeyedIndex<Key>> entries(students.size());
+    forEachSlice(threadPool().get(), students.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            entries[i] = {Key(extract(students[i], static_cast<int>(i))), static_cast<int>(i)};
+        }
+    });
+    
+    int direction = ascending ? 1 : -1;
+    sortRows(entries, [direction](const KeyedIndex<Key>& a, const KeyedIndex<Key>& b) {
+        int order = compareKeys(a.key, b.key) * direction;
+        return order < 0 || (order == 0 && a.index < b.index);
+    });
     
-    for (int j = low; j < high; j++) {
-        int cmp = compare(students[j], pivot, field);
-        bool shouldSwap = ascending ? (cmp < 0) : (cmp > 0);
+    vector<int> order;
+    order.reserve(entries.size());
+    for (const KeyedIndex<Key>& entry : entries) {
+        order.push_back(entry.index);
+    }
+    return order;
+}
+
+void Sorter::setThreadCount(int threads) {
+    PoolSetting& setting = poolSetting();
+    lock_guard<mutex> lock(setting.lock);
+    // Sorts already running keep the old pool alive until they finish.
+    setting.pool.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+}
+
+int Sorter::getThreadCount() {
+    shared_ptr<ThreadPool> pool = threadPool();
+    return pool ? pool->size() : 1;
+}
+
+Sorter::PoolSetting& Sorter::poolSetting() {
+    static PoolSetting setting;
+    return setting;
+}
+
+shared_ptr<ThreadPool> Sorter::threadPool() {
+    PoolSetting& setting = poolSetting();
+    lock_guard<mutex> lock(setting.lock);
+    return setting.pool;
+}
+
+int Sorter::slicesFor(const ThreadPool* pool, size_t count) {
+    return pool ? max<int>(1, min<size_t>(pool->size(), count / PARALLEL_SORT_MIN_ROWS)) : 1;
+}
+
+template <typename Fn>
+void Sorter::forEachSlice(ThreadPool* pool, size_t count, Fn fn) {
+    int slices = slicesFor(pool, count);
+    if (slices <= 1) {
+        fn(0, count);
+        return;
+    }
+    
+    vector<future<void>> pending;
+    pending.reserve(slices);
+    for (int slice = 0; slice < slices; ++slice) {
+        size_t begin = count * slice / slices;
+        size_t end = count * (slice + 1) / slices;
+        pending.push_back(pool->submit([&fn, begin, end] { fn(begin, end); }));
+    }
+    for (auto& done : pending) {
+        done.get();
+    }
+}
+
+// Parallel merge sort: one introsorted chunk per worker, then rounds that
+// merge neighbouring runs. Each merge is cut along its merge path into
+// independent pieces, so the last round, one merge of the whole roster,
+// still uses every worker.
+template <typename Row, typename Less>
+void Sorter::sortRows(vector<Row>& rows, Less less) {
+    shared_ptr<ThreadPool> pool = threadPool();
+    int chunks = slicesFor(pool.get(), rows.size());
+    if (chunks <= 1) {
+        introSort(rows.begin(), rows.end(), less);
+        return;
+    }
+    
+    forEachSlice(pool.get(), rows.size(), [&rows, &less](size_t begin, size_t end) {
+        introSort(rows.begin() + begin, rows.begin() + end, less);
+    });
+    
+    // Run boundaries, matching forEachSlice()'s slices.
+    vector<size_t> bounds;
+    for (int chunk = 0; chunk <= chunks; ++chunk) {
+        bounds.push_back(rows.size() * chunk / chunks);
+    }
+    
+    vector<Row> buffer(rows.size());
+    Row* from = rows.data();
+    Row* to = buffer.data();
+    while (bounds.size() > 2) {
+        int runs = bounds.size() - 1;
+        int pieces = max(1, chunks / ((runs + 1) / 2));
+        vector<size_t> merged;
+        vector<future<void>> pending;
         
-        if (shouldSwap) {
-            i++;
-            swap(students[i], students[j]);
+        // A run without a partner is merged with an empty one: a copy.
+        for (int run = 0; run < runs; run += 2) {
+            size_t first = bounds[run];
+            size_t middle = bounds[run + 1];
+            size_t last = run + 2 <= runs ? bounds[run + 2] : middle;
+            merged.push_back(first);
+            
+            Row* a = from + first;
+            Row* b = from + middle;
+            size_t sizeA = middle - first;
+            size_t sizeB = last - middle;
+            for (int piece = 0; piece < pieces; ++piece) {
+                size_t begin = (last - first) * piece / pieces;
+                size_t end = (last - first) * (piece + 1) / pieces;
+                Row* out = to + first + begin;
+                pending.push_back(pool->submit([a, b, sizeA, sizeB, begin, end, out, &less] {
+                    size_t fromA = mergePathSplit(a, sizeA, b, sizeB, begin, less);
+                    size_t toA = mergePathSplit(a, sizeA, b, sizeB, end, less);
+                    merge(make_move_iterator(a + fromA), make_move_iterator(a + toA),
+                          make_move_iterator(b + (begin - fromA)), make_move_iterator(b + (end - toA)),
+                          out, less);
+                }));
+            }
+        }
+        merged.push_back(bounds.back());
+        
+        for (auto& done : pending) {
+            done.get();
+        }
+        bounds.swap(merged);
+        swap(from, to);
+    }
+    
+    if (from != rows.data()) {
+        rows.swap(buffer);
+    }
+}
+
+// How many of the first `diagonal` rows of merge(a, b) come from `a`, with
+// ties taken from `a` first as merge() does.
+template <typename Iterator, typename Less>
+size_t Sorter::mergePathSplit(Iterator a, size_t sizeA, Iterator b, size_t sizeB, size_t diagonal, Less& less) {
+    size_t low = diagonal > sizeB ? diagonal - sizeB : 0;
+    size_t high = min(diagonal, sizeA);
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (!less(b[diagonal - mid - 1], a[mid])) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
-    swap(students[i + 1], students[high]);
-    return i + 1;
+    return low;
+}
+
+template <typename Iterator, typename Less>
+void Sorter::introSort(Iterator first, Iterator last, Less less) {
+    auto size = last - first;
+    if (size < 2) {
+        return;
+    }
+    
+    // The roster usually arrives sorted by ID, and re-sorting a sorted view
+    // is common: catch both directions before partitioning anything.
+    if (is_sorted(first, last, less)) {
+        return;
+    }
+    auto descending = [&](const auto& a, const auto& b) { return less(b, a); };
+    if (is_sorted(first, last, descending)) {
+        reverse(first, last);
+        return;
+    }
+    
+    int depthLimit = 0;
+    for (auto n = size; n > 1; n >>= 1) {
+        depthLimit += 2;
+    }
+    introSortLoop(first, last, depthLimit, true, less);
+}
+
+template <typename Iterator, typename Less>
+void Sorter::introSortLoop(Iterator first, Iterator last, int depthLimit, bool leftmost, Less& less) {
+    while (last - first > INSERTION_SORT_THRESHOLD) {
+        if (depthLimit-- == 0) {
+            make_heap(first, last, less);
+            sort_heap(first, last, less);
+            return;
+        }
+        
+        // Move the pivot to *first.
+        auto size = last - first;
+        Iterator middle = first + size / 2;
+        if (size > NINTHER_THRESHOLD) {
+            sort3(first, middle, last - 1, less);
+            sort3(first + 1, middle - 1, last - 2, less);
+            sort3(first + 2, middle + 1, last - 3, less);
+            sort3(middle - 1, middle, middle + 1, less);
+            iter_swap(first, middle);
+        } else {
+            sort3(middle, first, last - 1, less);
+        }
+        
+        // Everything here is >= the element before the range (an earlier
+        // pivot). If the new pivot equals it, so does everything that isn't
+        // greater: put those in place in one pass and go on with the rest.
+        if (!leftmost && !less(*(first - 1), *first)) {
+            first = partitionEqualToPivot(first, last, less);
+            continue;
+        }
+        
+        bool alreadyPartitioned;
+        Iterator pivot = partitionAroundPivot(first, last, less, alreadyPartitioned);
+        
+        // No swaps needed: the range may be nearly sorted, which insertion
+        // sort finishes quickly. Give up after a few moves.
+        if (alreadyPartitioned && partialInsertionSort(first, pivot, less) &&
+            partialInsertionSort(pivot + 1, last, less)) {
+            return;
+        }
+        
+        // Recurse into the smaller side and loop on the larger one.
+        if (pivot - first < last - pivot) {
+            introSortLoop(first, pivot, depthLimit, leftmost, less);
+            first = pivot + 1;
+            leftmost = false;
+        } else {
+            introSortLoop(pivot + 1, last, depthLimit, false, less);
+            last = pivot;
+        }
+    }
+    
+    insertionSort(first, last, less);
+}
+
+// Orders *a <= *b <= *c.
+template <typename Iterator, typename Less>
+void Sorter::sort3(Iterator a, Iterator b, Iterator c, Less& less) {
+    if (less(*b, *a)) iter_swap(a, b);
+    if (less(*c, *b)) iter_swap(b, c);
+    if (less(*b, *a)) iter_swap(a, b);
+}
+
+// Hoare partition around the pivot at *first: smaller elements to its left,
+// the rest to its right. Returns the pivot's final position.
+template <typename Iterator, typename Less>
+Iterator Sorter::partitionAroundPivot(Iterator first, Iterator last, Less& less, bool& alreadyPartitioned) {
+    Iterator i = first + 1;
+    Iterator j = last - 1;
+    while (i <= j && less(*i, *first)) ++i;
+    while (i <= j && !less(*j, *first)) --j;
+    alreadyPartitioned = i > j;
+    
+    // After each swap *i < pivot <= *j, which bounds both scans.
+    while (i < j) {
+        iter_swap(i, j);
+        while (less(*++i, *first));
+        while (!less(*--j, *first));
+    }
+    
+    iter_swap(first, j);
+    return j;
+}
+
+// Moves the elements equal to the pivot at *first (none are smaller) to the
+// front and returns the first greater one.
+template <typename Iterator, typename Less>
+Iterator Sorter::partitionEqualToPivot(Iterator first, Iterator last, Less& less) {
+    Iterator i = first + 1;
+    Iterator j = last - 1;
+    while (i <= j && !less(*first, *i)) ++i;
+    while (i <= j && less(*first, *j)) --j;
+    
+    while (i < j) {
+        iter_swap(i, j);
+        while (!less(*first, *++i));
+        while (less(*first, *--j));
+    }
+    
+    return j + 1;
+}
+
+template <typename Iterator, typename Less>
+void Sorter::insertionSort(Iterator first, Iterator last, Less& less) {
+    if (first == last) {
+        return;
+    }
+    
+    for (Iterator i = first + 1; i != last; ++i) {
+        if (!less(*i, *(i - 1))) {
+            continue;
+        }
+        auto value = move(*i);
+        Iterator j = i;
+        do {
+            *j = move(*(j - 1));
+            --j;
+        } while (j != first && less(value, *(j - 1)));
+        *j = move(value);
+    }
+}
+
+// Insertion sort that stops once it has moved PARTIAL_INSERTION_LIMIT
+// elements; returns whether the range ended up sorted.
+template <typename Iterator, typename Less>
+bool Sorter::partialInsertionSort(Iterator first, Iterator last, Less& less) {
+    if (first == last) {
+        return true;
+    }
+    
+    int moved = 0;
+    for (Iterator i = first + 1; i != last; ++i) {
+        if (!less(*i, *(i - 1))) {
+            continue;
+        }
+        auto value = move(*i);
+        Iterator j = i;
+        do {
+            *j = move(*(j - 1));
+            --j;
+        } while (j != first && less(value, *(j - 1)));
+        *j = move(value);
+        
+        moved += i - j;
+        if (moved > PARTIAL_INSERTION_LIMIT) {
+            return i + 1 == last;
+        }
+    }
+    return true;
 }
 
 int Sorter::compare(const Student& a, const Student& b, SortField field) {
@@ -60,28 +842,28 @@ int Sorter::compare(const Student& a, const Student& b, SortField field) {
             if (a.getSex() < b.getSex()) return -1;
             else if (a.getSex() > b.getSex()) return 1;
             break;
-            
+        
         case SortField::AGE:
             if (a.getAge() < b.getAge()) return -1;
             else if (a.getAge() > b.getAge()) return 1;
             break;
-            
+        
         case SortField::GPA:
             if (a.getGPA() < b.getGPA()) return -1;
             else if (a.getGPA() > b.getGPA()) return 1;
             break;
-            
+        
         case SortField::DEPARTMENT:
             return a.getDepartment().compare(b.getDepartment());
-            
+        
         case SortField::YEAR_OF_STUDY:
             if (a.getYearOfStudy() < b.getYearOfStudy()) return -1;
             else if (a.getYearOfStudy() > b.getYearOfStudy()) return 1;
             break;
-            
+        
         case SortField::ID:
             return a.getId().compare(b.getId());
-            
+        
         case SortField::NAME:
             return a.getFullName().compare(b.getFullName());
     }
@@ -3,6 +3,7 @@
 #include <vector>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 
 using namespace std;
 
@@ -25,6 +26,8 @@ private:
     string passwordHash;
     string firstName;
     string lastName;
+    string firstNameKey;    // case-folded copies for name search
+    string lastNameKey;
     string department;
     int age;
     char sex;
@@ -41,10 +44,12 @@ public:
             int yearOfStudy, const string& section);
     
   
-    string getId() const { return id; }
+    const string& getId() const { return id; }
     string getPasswordHash() const { return passwordHash; }
     string getFirstName() const { return firstName; }
     string getLastName() const { return lastName; }
+    const string& getFirstNameKey() const { return firstNameKey; }
+    const string& getLastNameKey() const { return lastNameKey; }
     string getFullName() const { return firstName + " " + lastName; }
     string getDepartment() const { return department; }
     int getAge() const { return age; }
@@ -57,8 +62,8 @@ public:
  
     void setId(const string& newId) { id = newId; }
     void setPassword(const string& password);
-    void setFirstName(const string& name) { firstName = name; }
-    void setLastName(const string& name) { lastName = name; }
+    void setFirstName(const string& name) { firstName = name; firstNameKey = Utils::toLower(name); }
+    void setLastName(const string& name) { lastName = name; lastNameKey = Utils::toLower(name); }
     void setDepartment(const string& dept) { department = dept; }
     void setAge(int newAge) { age = newAge; }
     void setSex(char newSex) { sex = newSex; }
@@ -89,7 +94,13 @@ public:
     bool operator==(const Student& other) const { return id == other.id; }
 };
 
+// Orders students in the primary index by ID without copying it.
+struct StudentIdKey {
+    string_view operator()(const Student& student) const { return student.getId(); }
+};
+
 Student::Student() : id(""), passwordHash(""), firstName(""), lastName(""),
+                     firstNameKey(""), lastNameKey(""),
                      department(""), age(0), sex('M'), yearOfStudy(1),
                      section(""), gpa(0.0) {}
 
@@ -98,6 +109,7 @@ Student::Student(const string& id, const string& password,
                  const string& department, int age, char sex,
                  int yearOfStudy, const string& section)
     : id(id), firstName(firstName), lastName(lastName),
+      firstNameKey(Utils::toLower(firstName)), lastNameKey(Utils::toLower(lastName)),
       department(department), age(age), sex(sex),
       yearOfStudy(yearOfStudy), section(section), gpa(0.0) {
     setPassword(password);
@@ -227,8 +239,8 @@ Student Student::fromCSV(const string& csvLine) {
    
     student.id = fields[0];
     student.passwordHash = fields[1];
-    student.firstName = fields[2];
-    student.lastName = fields[3];
+    student.setFirstName(fields[2]);
+    student.setLastName(fields[3]);
     student.department = fields[4];
     student.age = stoi(fields[5]);
     student.sex = fields[6][0];
@@ -0,0 +1,582 @@
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Columnar (structure-of-arrays) mirror of the roster for the small numeric
+// and categorical search fields: one byte each for age, year of study and
+// sex, a dictionary-encoded department, and the GPA as a float. Filters over
+// these run 32 rows at a time with SIMD compares (AVX2 or SSE2 when the build
+// enables them, scalar otherwise), producing one 32-bit selection mask per
+// block without touching the Student records.
+//
+// The categorical fields (department, section, sex, year of study) also get
+// a RowBitmap of row numbers per value, so multi-field categorical queries
+// are ANDs and ORs of bitmaps.
+//
+// Rows are appended on add and tombstoned on remove. Rows up to sortedCount
+// are in ID order; the rest (the tail) are merged back in by compact(), which
+// runs once the tail and the tombstones outgrow an eighth of the live rows.
+class StudentColumns {
+public:
+    static constexpr size_t BLOCK = 32;
+
+private:
+    // Compiled form of the columnar part of a SearchCriteria.
+    struct ColumnQuery {
+        bool matchAll;
+        bool hasAge, hasYear, hasSex, hasDepartment, hasGpa;
+        bool anyPredicate;
+        int8_t age, year, sex;
+        uint8_t department;
+        bool departmentMissing;     // not in the dictionary, so nothing matches
+        float minGpa, maxGpa;
+    };
+    
+    static constexpr uint8_t OVERFLOW_DEPARTMENT = 255;
+    static constexpr size_t MIN_COMPACT_ROWS = 1024;
+    
+    vector<int8_t> ages;
+    vector<int8_t> years;
+    vector<int8_t> sexes;
+    vector<uint8_t> departments;
+    vector<float> gpas;
+    vector<int8_t> alive;           // -1 for a live row, 0 for a tombstone or padding
+    vector<const Student*> rows;
+    
+    unordered_map<const Student*, uint32_t> rowOf;
+    vector<string> departmentNames;
+    unordered_map<string, uint8_t> departmentCodes;
+    
+    // Live rows per value; rebuilt when compact() renumbers the rows.
+    unordered_map<string, RowBitmap> departmentRows;
+    unordered_map<string, RowBitmap> sectionRows;
+    unordered_map<int, RowBitmap> yearRows;
+    unordered_map<char, RowBitmap> sexRows;
+    
+    size_t rowCount;        // rows in use, live or dead
+    size_t sortedCount;
+    size_t deadCount;
+    string lastSortedId;
+    
+    static int8_t toColumnByte(int value);
+    static bool fitsColumnByte(int value);
+    uint8_t departmentCode(const string& department);
+    void compact();
+    void indexRow(const Student* student, uint32_t row);
+    void unindexRow(const Student* student, uint32_t row);
+    
+    // Appends rows[row] for each row forEachRow(visit) visits in ascending
+    // order, merging the unsorted tail so the output is in ID order.
+    template <typename ForEachRow>
+    void appendInIdOrder(ForEachRow forEachRow, vector<const Student*>& out) const;
+    
+    ColumnQuery compile(const SearchCriteria& criteria, SearchMode mode) const;
+    uint32_t blockMask(const ColumnQuery& query, size_t base) const;
+    
+    static uint32_t equalMask(const int8_t* column, int8_t value);
+    static uint32_t rangeMask(const float* column, float low, float high);
+    static uint32_t liveMask(const int8_t* column);
+
+public:
+    StudentColumns() : rowCount(0), sortedCount(0), deadCount(0) {}
+    
+    void add(const Student* student);
+    void remove(const Student* student);
+    void clear();
+    
+    size_t size() const { return rowCount - deadCount; }
+    
+    // Whether the column filter for `field` is exact for these criteria. GPA
+    // is stored as a float, so its filter is a superset to be rechecked on
+    // the selected rows, as are ages/years beyond a byte and departments past
+    // the 255-entry dictionary.
+    bool isExact(SearchField field, const SearchCriteria& criteria) const;
+    static bool isColumnar(SearchField field);
+    static bool isCategorical(SearchField field);
+    
+    // Appends the live rows passing the columnar criteria (AND or OR, as in
+    // `mode`) in ID order. Other fields of `criteria` are ignored.
+    void select(const SearchCriteria& criteria, SearchMode mode,
+                vector<const Student*>& out) const;
+    
+    // Same for the categorical criteria alone, answered exactly by ANDing or
+    // ORing their bitmaps 64 rows per word.
+    void selectByBitmaps(const SearchCriteria& criteria, SearchMode mode,
+                         vector<const Student*>& out) const;
+    
+    static const char* kernelName();
+};
+
+
+int8_t StudentColumns::toColumnByte(int value) {
+    return static_cast<int8_t>(max(-128, min(127, value)));
+}
+
+// Saturated values (-128, 127) are ambiguous, so they can't be filtered exactly.
+bool StudentColumns::fitsColumnByte(int value) {
+    return value > -128 && value < 127;
+}
+
+uint8_t StudentColumns::departmentCode(const string& department) {
+    auto it = departmentCodes.find(department);
+    if (it != departmentCodes.end()) {
+        return it->second;
+    }
+    
+    if (departmentNames.size() == OVERFLOW_DEPARTMENT) {
+        return OVERFLOW_DEPARTMENT;
+    }
+    
+    uint8_t code = static_cast<uint8_t>(departmentNames.size());
+    departmentNames.push_back(department);
+    departmentCodes.emplace(department, code);
+    return code;
+}
+
+void StudentColumns::add(const Student* student) {
+    if (rowCount == alive.size()) {
+        size_t capacity = rowCount + BLOCK;
+        ages.resize(capacity);
+        years.resize(capacity);
+        sexes.resize(capacity);
+        departments.resize(capacity);
+        gpas.resize(capacity);
+        alive.resize(capacity, 0);
+        rows.resize(capacity, nullptr);
+    }
+    
+    size_t row = rowCount++;
+    ages[row] = toColumnByte(student->getAge());
+    years[row] = toColumnByte(student->getYearOfStudy());
+    sexes[row] = static_cast<int8_t>(student->getSex());
+    departments[row] = departmentCode(student->getDepartment());
+    gpas[row] = static_cast<float>(student->getGPA());
+    alive[row] = -1;
+    rows[row] = student;
+    rowOf[student] = static_cast<uint32_t>(row);
+    indexRow(student, static_cast<uint32_t>(row));
+    
+    // Rows arriving in ID order (such as a bulk load) extend the sorted part.
+    if (row == sortedCount && (sortedCount == 0 || lastSortedId < student->getId())) {
+        sortedCount++;
+        lastSortedId = student->getId();
+    }
+    
+    if (rowCount - sortedCount + deadCount > max(MIN_COMPACT_ROWS, size() / 8)) {
+        compact();
+    }
+}
+
+void StudentColumns::remove(const Student* student) {
+    auto it = rowOf.find(student);
+    if (it == rowOf.end()) {
+        return;
+    }
+    
+    unindexRow(student, it->second);
+    alive[it->second] = 0;
+    rows[it->second] = nullptr;
+    rowOf.erase(it);
+    deadCount++;
+    
+    if (rowCount - sortedCount + deadCount > max(MIN_COMPACT_ROWS, size() / 8)) {
+        compact();
+    }
+}
+
+void StudentColumns::clear() {
+    ages.clear();
+    years.clear();
+    sexes.clear();
+    departments.clear();
+    gpas.clear();
+    alive.clear();
+    rows.clear();
+    rowOf.clear();
+    departmentNames.clear();
+    departmentCodes.clear();
+    departmentRows.clear();
+    sectionRows.clear();
+    yearRows.clear();
+    sexRows.clear();
+    rowCount = 0;
+    sortedCount = 0;
+    deadCount = 0;
+    lastSortedId.clear();
+}
+
+// Drops tombstones and merges the sorted tail into the ordered part; column
+// values move with their rows, so no record is read except to order the tail.
+void StudentColumns::compact() {
+    vector<uint32_t> order;
+    order.reserve(size());
+    for (size_t row = 0; row < sortedCount; ++row) {
+        if (alive[row]) order.push_back(static_cast<uint32_t>(row));
+    }
+    
+    size_t sortedLive = order.size();
+    for (size_t row = sortedCount; row < rowCount; ++row) {
+        if (alive[row]) order.push_back(static_cast<uint32_t>(row));
+    }
+    
+    auto byId = [this](uint32_t a, uint32_t b) { return rows[a]->getId() < rows[b]->getId(); };
+    sort(order.begin() + sortedLive, order.end(), byId);
+    inplace_merge(order.begin(), order.begin() + sortedLive, order.end(), byId);
+    
+    size_t capacity = (order.size() + BLOCK - 1) / BLOCK * BLOCK;
+    auto gather = [&](auto& column, auto padding) {
+        typename decay<decltype(column)>::type packed(capacity, padding);
+        for (size_t i = 0; i < order.size(); ++i) {
+            packed[i] = column[order[i]];
+        }
+        column.swap(packed);
+    };
+    gather(ages, int8_t(0));
+    gather(years, int8_t(0));
+    gather(sexes, int8_t(0));
+    gather(departments, uint8_t(0));
+    gather(gpas, 0.0f);
+    gather(alive, int8_t(0));
+    gather(rows, static_cast<const Student*>(nullptr));
+    
+    rowCount = order.size();
+    sortedCount = rowCount;
+    deadCount = 0;
+    lastSortedId = rowCount > 0 ? rows[rowCount - 1]->getId() : string();
+    
+    rowOf.clear();
+    departmentRows.clear();
+    sectionRows.clear();
+    yearRows.clear();
+    sexRows.clear();
+    for (size_t row = 0; row < rowCount; ++row) {
+        rowOf[rows[row]] = static_cast<uint32_t>(row);
+        indexRow(rows[row], static_cast<uint32_t>(row));
+    }
+}
+
+void StudentColumns::indexRow(const Student* student, uint32_t row) {
+    departmentRows[student->getDepartment()].add(row);
+    sectionRows[student->getSection()].add(row);
+    yearRows[student->getYearOfStudy()].add(row);
+    sexRows[student->getSex()].add(row);
+}
+
+// Drops a value's bitmap once it is empty, like StudentIndex's postings.
+void StudentColumns::unindexRow(const Student* student, uint32_t row) {
+    auto unindex = [row](auto& bitmaps, const auto& key) {
+        auto it = bitmaps.find(key);
+        if (it == bitmaps.end()) {
+            return;
+        }
+        it->second.remove(row);
+        if (it->second.empty()) {
+            bitmaps.erase(it);
+        }
+    };
+    unindex(departmentRows, student->getDepartment());
+    unindex(sectionRows, student->getSection());
+    unindex(yearRows, student->getYearOfStudy());
+    unindex(sexRows, student->getSex());
+}
+
+bool StudentColumns::isColumnar(SearchField field) {
+    return field == SearchField::AGE || field == SearchField::YEAR_OF_STUDY ||
+           field == SearchField::SEX || field == SearchField::DEPARTMENT ||
+           field == SearchField::GPA_RANGE;
+}
+
+bool StudentColumns::isCategorical(SearchField field) {
+    return field == SearchField::DEPARTMENT || field == SearchField::SECTION ||
+           field == SearchField::YEAR_OF_STUDY || field == SearchField::SEX;
+}
+
+bool StudentColumns::isExact(SearchField field, const SearchCriteria& criteria) const {
+    switch (field) {
+        case SearchField::AGE:
+            return fitsColumnByte(criteria.age);
+        case SearchField::YEAR_OF_STUDY:
+            return fitsColumnByte(criteria.yearOfStudy);
+        case SearchField::SEX:
+            return true;
+        case SearchField::DEPARTMENT: {
+            auto it = departmentCodes.find(criteria.department);
+            if (it == departmentCodes.end()) {
+                return departmentNames.size() < OVERFLOW_DEPARTMENT;
+            }
+            return it->second != OVERFLOW_DEPARTMENT;
+        }
+        default:
+            return false;
+    }
+}
+
+StudentColumns::ColumnQuery StudentColumns::compile(const SearchCriteria& criteria,
+                                                    SearchMode mode) const {
+    ColumnQuery query = {};
+    query.matchAll = mode == SearchMode::MATCH_ALL;
+    
+    // Predicates that can't be decided from the columns are left out: under
+    // AND that widens the selection, and under OR a filter that might match
+    // anything selects every row.
+    bool selectEverything = false;
+    auto undecided = [&] { if (!query.matchAll) selectEverything = true; };
+    
+    if (criteria.age != -1) {
+        if (isExact(SearchField::AGE, criteria)) {
+            query.hasAge = true;
+            query.age = static_cast<int8_t>(criteria.age);
+        } else {
+            undecided();
+        }
+    }
+    
+    if (criteria.yearOfStudy != -1) {
+        if (isExact(SearchField::YEAR_OF_STUDY, criteria)) {
+            query.hasYear = true;
+            query.year = static_cast<int8_t>(criteria.yearOfStudy);
+        } else {
+            undecided();
+        }
+    }
+    
+    if (criteria.sex != '\0') {
+        query.hasSex = true;
+        query.sex = static_cast<int8_t>(criteria.sex);
+    }
+    
+    if (!criteria.department.empty()) {
+        auto it = departmentCodes.find(criteria.department);
+        if (!isExact(SearchField::DEPARTMENT, criteria)) {
+            undecided();
+        } else if (it == departmentCodes.end()) {
+            query.departmentMissing = true;
+        } else {
+            query.hasDepartment = true;
+            query.department = it->second;
+        }
+    }
+    
+    if (SearchManager::hasGpaRange(criteria)) {
+        // Widened by one float step on each side so rounding to float can
+        // only let extra rows through, never drop one.
+        query.hasGpa = true;
+        query.minGpa = criteria.minGPA != -1.0
+            ? nextafter(static_cast<float>(criteria.minGPA), -numeric_limits<float>::infinity())
+            : -numeric_limits<float>::infinity();
+        query.maxGpa = criteria.maxGPA != -1.0
+            ? nextafter(static_cast<float>(criteria.maxGPA), numeric_limits<float>::infinity())
+            : numeric_limits<float>::infinity();
+    }
+    
+    if (selectEverything) {
+        query.hasAge = query.hasYear = query.hasSex = query.hasDepartment = query.hasGpa = false;
+        query.departmentMissing = false;
+        query.matchAll = true;
+    }
+    
+    query.anyPredicate = query.hasAge || query.hasYear || query.hasSex || query.hasDepartment ||
+                         query.hasGpa || query.departmentMissing;
+    return query;
+}
+
+uint32_t StudentColumns::blockMask(const ColumnQuery& query, size_t base) const {
+    uint32_t live = liveMask(&alive[base]);
+    
+    if (query.matchAll) {
+        uint32_t mask = query.departmentMissing ? 0 : live;
+        if (mask && query.hasDepartment) mask &= equalMask(reinterpret_cast<const int8_t*>(&departments[base]),
+                                                           static_cast<int8_t>(query.department));
+        if (mask && query.hasYear) mask &= equalMask(&years[base], query.year);
+        if (mask && query.hasAge) mask &= equalMask(&ages[base], query.age);
+        if (mask && query.hasSex) mask &= equalMask(&sexes[base], query.sex);
+        if (mask && query.hasGpa) mask &= rangeMask(&gpas[base], query.minGpa, query.maxGpa);
+        return mask;
+    }
+    
+    uint32_t mask = 0;
+    if (query.hasDepartment) mask |= equalMask(reinterpret_cast<const int8_t*>(&departments[base]),
+                                               static_cast<int8_t>(query.department));
+    if (query.hasYear) mask |= equalMask(&years[base], query.year);
+    if (query.hasAge) mask |= equalMask(&ages[base], query.age);
+    if (query.hasSex) mask |= equalMask(&sexes[base], query.sex);
+    if (query.hasGpa) mask |= rangeMask(&gpas[base], query.minGpa, query.maxGpa);
+    return mask & live;
+}
+
+void StudentColumns::select(const SearchCriteria& criteria, SearchMode mode,
+                            vector<const Student*>& out) const {
+    ColumnQuery query = compile(criteria, mode);
+    if (!query.matchAll && !query.anyPredicate) {
+        return;
+    }
+    
+    appendInIdOrder([&](auto visit) {
+        for (size_t base = 0; base < rowCount; base += BLOCK) {
+            uint32_t mask = blockMask(query, base);
+            while (mask) {
+                visit(base + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+    }, out);
+}
+
+void StudentColumns::selectByBitmaps(const SearchCriteria& criteria, SearchMode mode,
+                                     vector<const Student*>& out) const {
+    static const RowBitmap none;
+    auto bitmapFor = [](const auto& bitmaps, const auto& key) -> const RowBitmap* {
+        auto it = bitmaps.find(key);
+        return it != bitmaps.end() ? &it->second : &none;
+    };
+    
+    vector<const RowBitmap*> operands;
+    if (!criteria.department.empty()) operands.push_back(bitmapFor(departmentRows, criteria.department));
+    if (!criteria.section.empty()) operands.push_back(bitmapFor(sectionRows, criteria.section));
+    if (criteria.yearOfStudy != -1) operands.push_back(bitmapFor(yearRows, criteria.yearOfStudy));
+    if (criteria.sex != '\0') operands.push_back(bitmapFor(sexRows, criteria.sex));
+    
+    if (operands.empty()) {
+        return;
+    }
+    
+    // Intersections start from the smallest bitmap, so the intermediate
+    // results only shrink.
+    RowBitmap combined;
+    const RowBitmap* result = operands[0];
+    if (operands.size() > 1) {
+        if (mode == SearchMode::MATCH_ALL) {
+            sort(operands.begin(), operands.end(), [](const RowBitmap* a, const RowBitmap* b) {
+                return a->cardinality() < b->cardinality();
+            });
+            combined = RowBitmap::intersect(*operands[0], *operands[1]);
+            for (size_t i = 2; i < operands.size() && !combined.empty(); ++i) {
+                combined = RowBitmap::intersect(combined, *operands[i]);
+            }
+        } else {
+            combined = RowBitmap::unite(*operands[0], *operands[1]);
+            for (size_t i = 2; i < operands.size(); ++i) {
+                combined = RowBitmap::unite(combined, *operands[i]);
+            }
+        }
+        result = &combined;
+    }
+    
+    appendInIdOrder([&](auto visit) { result->forEach(visit); }, out);
+}
+
+template <typename ForEachRow>
+void StudentColumns::appendInIdOrder(ForEachRow forEachRow, vector<const Student*>& out) const {
+    size_t first = out.size();
+    vector<const Student*> tail;
+    
+    forEachRow([&](size_t row) {
+        (row < sortedCount ? out : tail).push_back(rows[row]);
+    });
+    
+    if (!tail.empty()) {
+        auto byId = [](const Student* a, const Student* b) { return a->getId() < b->getId(); };
+        sort(tail.begin(), tail.end(), byId);
+        size_t middle = out.size();
+        out.insert(out.end(), tail.begin(), tail.end());
+        inplace_merge(out.begin() + first, out.begin() + middle, out.end(), byId);
+    }
+}
+
+#if defined(__AVX2__)
+
+uint32_t StudentColumns::equalMask(const int8_t* column, int8_t value) {
+    __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(values, _mm256_set1_epi8(value))));
+}
+
+uint32_t StudentColumns::rangeMask(const float* column, float low, float high) {
+    __m256 lows = _mm256_set1_ps(low);
+    __m256 highs = _mm256_set1_ps(high);
+    uint32_t mask = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+        __m256 values = _mm256_loadu_ps(column + lane * 8);
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(values, lows, _CMP_GE_OQ),
+                                      _mm256_cmp_ps(values, highs, _CMP_LE_OQ));
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(inside)) << (lane * 8);
+    }
+    return mask;
+}
+
+uint32_t StudentColumns::liveMask(const int8_t* column) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column))));
+}
+
+const char* StudentColumns::kernelName() { return "AVX2"; }
+
+#elif defined(__SSE2__)
+
+uint32_t StudentColumns::equalMask(const int8_t* column, int8_t value) {
+    __m128i target = _mm_set1_epi8(value);
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + 16));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, target))) |
+           static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, target))) << 16;
+}
+
+uint32_t StudentColumns::rangeMask(const float* column, float low, float high) {
+    __m128 lows = _mm_set1_ps(low);
+    __m128 highs = _mm_set1_ps(high);
+    uint32_t mask = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+        __m128 values = _mm_loadu_ps(column + lane * 4);
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(values, lows), _mm_cmple_ps(values, highs));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(inside)) << (lane * 4);
+    }
+    return mask;
+}
+
+uint32_t StudentColumns::liveMask(const int8_t* column) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + 16));
+    return static_cast<uint32_t>(_mm_movemask_epi8(low)) |
+           static_cast<uint32_t>(_mm_movemask_epi8(high)) << 16;
+}
+
+const char* StudentColumns::kernelName() { return "SSE2"; }
+
+#else
+
+uint32_t StudentColumns::equalMask(const int8_t* column, int8_t value) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        mask |= static_cast<uint32_t>(column[i] == value) << i;
+    }
+    return mask;
+}
+
+uint32_t StudentColumns::rangeMask(const float* column, float low, float high) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        mask |= static_cast<uint32_t>(column[i] >= low && column[i] <= high) << i;
+    }
+    return mask;
+}
+
+uint32_t StudentColumns::liveMask(const int8_t* column) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        mask |= static_cast<uint32_t>(column[i] != 0) << i;
+    }
+    return mask;
+}
+
+const char* StudentColumns::kernelName() { return "scalar"; }
+
+#endif
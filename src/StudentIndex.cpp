@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Orders record pointers by student ID, so posting lists come out in the same
+// order as the primary index.
+struct StudentPtrIdLess {
+    bool operator()(const Student* a, const Student* b) const {
+        return a->getId() < b->getId();
+    }
+};
+
+// Orders record pointers by GPA, then ID. A bare GPA can be used as a probe.
+struct StudentPtrGpaLess {
+    using is_transparent = void;
+    
+    bool operator()(const Student* a, const Student* b) const {
+        if (a->getGPA() != b->getGPA()) {
+            return a->getGPA() < b->getGPA();
+        }
+        return a->getId() < b->getId();
+    }
+    
+    bool operator()(const Student* a, double gpa) const { return a->getGPA() < gpa; }
+    bool operator()(double gpa, const Student* b) const { return gpa < b->getGPA(); }
+};
+
+// Secondary indexes kept by StudentManager next to the primary store: hash
+// indexes on department, year of study, section and the three combined (a
+// cohort such as "SE year 3 section B"), an ordered index on GPA, and
+// trigram indexes, BK-trees and radix tries on the case-folded first and last
+// names, plus a columnar copy of the numeric fields for vectorized scans.
+// Entries point at records owned by the store, so a record has to be removed
+// here before it is changed or erased, and added back afterwards.
+class StudentIndex {
+public:
+    using Posting = set<const Student*, StudentPtrIdLess>;
+
+private:
+    unordered_map<string, Posting> byDepartment;
+    unordered_map<int, Posting> byYear;
+    unordered_map<string, Posting> bySection;
+    unordered_map<string, Posting> byCohort;
+    set<const Student*, StudentPtrGpaLess> byGPA;
+    vector<int> gpaHistogram;   // students per 0.1 GPA band, for estimates
+    TrigramIndex firstNames;
+    TrigramIndex lastNames;
+    BKTree fuzzyFirstNames;
+    BKTree fuzzyLastNames;
+    RadixTrie firstNamePrefixes;
+    RadixTrie lastNamePrefixes;
+    StudentColumns columnar;
+    
+    static constexpr int GPA_BANDS = 41;
+    static int gpaBand(double gpa);
+    
+    static string cohortKey(const string& department, int yearOfStudy, const string& section);
+    
+    template <typename Key>
+    static void removeFrom(unordered_map<Key, Posting>& index, const Key& key,
+                           const Student* student);
+    
+    // add(), with the name postings left unsorted when `bulk` is set.
+    void addRecord(const Student* student, bool bulk);
+    
+    template <typename Key>
+    static const Posting& lookup(const unordered_map<Key, Posting>& index, const Key& key);
+
+public:
+    StudentIndex() : gpaHistogram(GPA_BANDS, 0) {}
+    
+    void add(const Student* student);
+    
+    // Adds every Student in `students`. Sorts each name posting list once at
+    // the end instead of inserting into it per record.
+    template <typename Range>
+    void addAll(const Range& students);
+    void remove(const Student* student);
+    void clear();
+    
+    // Students with the given value in ID order; empty if there are none.
+    const Posting& withDepartment(const string& department) const;
+    const Posting& withYear(int yearOfStudy) const;
+    const Posting& withSection(const string& section) const;
+    const Posting& withCohort(const string& department, int yearOfStudy,
+                              const string& section) const;
+    
+    // Visits students with minGPA <= GPA <= maxGPA in GPA order. A negative
+    // bound is open, as in SearchCriteria.
+    template <typename Visitor>
+    void forEachInGpaRange(double minGPA, double maxGPA, Visitor visit) const;
+    
+    // Upper-bound estimate of forEachInGpaRange's row count, in O(1).
+    int estimateGpaRange(double minGPA, double maxGPA) const;
+    
+    const TrigramIndex& firstNameTrigrams() const { return firstNames; }
+    const TrigramIndex& lastNameTrigrams() const { return lastNames; }
+    const BKTree& firstNameTree() const { return fuzzyFirstNames; }
+    const BKTree& lastNameTree() const { return fuzzyLastNames; }
+    const RadixTrie& firstNameTrie() const { return firstNamePrefixes; }
+    const RadixTrie& lastNameTrie() const { return lastNamePrefixes; }
+    const StudentColumns& columns() const { return columnar; }
+};
+
+
+template <typename Key>
+void StudentIndex::removeFrom(unordered_map<Key, Posting>& index, const Key& key,
+                              const Student* student) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return;
+    }
+    
+    it->second.erase(student);
+    if (it->second.empty()) {
+        index.erase(it);
+    }
+}
+
+template <typename Key>
+const StudentIndex::Posting& StudentIndex::lookup(const unordered_map<Key, Posting>& index,
+                                                  const Key& key) {
+    static const Posting empty;
+    auto it = index.find(key);
+    return it != index.end() ? it->second : empty;
+}
+
+string StudentIndex::cohortKey(const string& department, int yearOfStudy, const string& section) {
+    return department + '\x1f' + to_string(yearOfStudy) + '\x1f' + section;
+}
+
+int StudentIndex::gpaBand(double gpa) {
+    return max(0, min(GPA_BANDS - 1, static_cast<int>(gpa * 10)));
+}
+
+void StudentIndex::add(const Student* student) {
+    addRecord(student, false);
+}
+
+template <typename Range>
+void StudentIndex::addAll(const Range& students) {
+    for (const Student& student : students) {
+        addRecord(&student, true);
+    }
+    firstNames.sortAppended();
+    lastNames.sortAppended();
+    fuzzyFirstNames.sortAppended();
+    fuzzyLastNames.sortAppended();
+}
+
+void StudentIndex::addRecord(const Student* student, bool bulk) {
+    byDepartment[student->getDepartment()].insert(student);
+    byYear[student->getYearOfStudy()].insert(student);
+    bySection[student->getSection()].insert(student);
+    byCohort[cohortKey(student->getDepartment(), student->getYearOfStudy(),
+                       student->getSection())].insert(student);
+    byGPA.insert(student);
+    gpaHistogram[gpaBand(student->getGPA())]++;
+    if (bulk) {
+        firstNames.append(student, student->getFirstNameKey());
+        lastNames.append(student, student->getLastNameKey());
+        fuzzyFirstNames.append(student, student->getFirstNameKey());
+        fuzzyLastNames.append(student, student->getLastNameKey());
+    } else {
+        firstNames.add(student, student->getFirstNameKey());
+        lastNames.add(student, student->getLastNameKey());
+        fuzzyFirstNames.add(student, student->getFirstNameKey());
+        fuzzyLastNames.add(student, student->getLastNameKey());
+    }
+    firstNamePrefixes.add(student, student->getFirstNameKey());
+    lastNamePrefixes.add(student, student->getLastNameKey());
+    columnar.add(student);
+}
+
+void StudentIndex::remove(const Student* student) {
+    removeFrom(byDepartment, student->getDepartment(), student);
+    removeFrom(byYear, student->getYearOfStudy(), student);
+    removeFrom(bySection, student->getSection(), student);
+    removeFrom(byCohort, cohortKey(student->getDepartment(), student->getYearOfStudy(),
+                                   student->getSection()), student);
+    if (byGPA.erase(student)) {
+        gpaHistogram[gpaBand(student->getGPA())]--;
+    }
+    firstNames.remove(student, student->getFirstNameKey());
+    lastNames.remove(student, student->getLastNameKey());
+    fuzzyFirstNames.remove(student, student->getFirstNameKey());
+    fuzzyLastNames.remove(student, student->getLastNameKey());
+    firstNamePrefixes.remove(student, student->getFirstNameKey());
+    lastNamePrefixes.remove(student, student->getLastNameKey());
+    columnar.remove(student);
+}
+
+void StudentIndex::clear() {
+    byDepartment.clear();
+    byYear.clear();
+    bySection.clear();
+    byCohort.clear();
+    byGPA.clear();
+    fill(gpaHistogram.begin(), gpaHistogram.end(), 0);
+    firstNames.clear();
+    lastNames.clear();
+    fuzzyFirstNames.clear();
+    fuzzyLastNames.clear();
+    firstNamePrefixes.clear();
+    lastNamePrefixes.clear();
+    columnar.clear();
+}
+
+const StudentIndex::Posting& StudentIndex::withDepartment(const string& department) const {
+    return lookup(byDepartment, department);
+}
+
+const StudentIndex::Posting& StudentIndex::withYear(int yearOfStudy) const {
+    return lookup(byYear, yearOfStudy);
+}
+
+const StudentIndex::Posting& StudentIndex::withSection(const string& section) const {
+    return lookup(bySection, section);
+}
+
+const StudentIndex::Posting& StudentIndex::withCohort(const string& department, int yearOfStudy,
+                                                      const string& section) const {
+    return lookup(byCohort, cohortKey(department, yearOfStudy, section));
+}
+
+template <typename Visitor>
+void StudentIndex::forEachInGpaRange(double minGPA, double maxGPA, Visitor visit) const {
+    if (minGPA >= 0 && maxGPA >= 0 && minGPA > maxGPA) {
+        return;
+    }
+    
+    auto it = minGPA < 0 ? byGPA.begin() : byGPA.lower_bound(minGPA);
+    auto end = maxGPA < 0 ? byGPA.end() : byGPA.upper_bound(maxGPA);
+    
+    for (; it != end; ++it) {
+        visit(*it);
+    }
+}
+
+int StudentIndex::estimateGpaRange(double minGPA, double maxGPA) const {
+    int first = minGPA < 0 ? 0 : gpaBand(minGPA);
+    int last = maxGPA < 0 ? GPA_BANDS - 1 : gpaBand(maxGPA);
+    
+    int rows = 0;
+    for (int band = first; band <= last; ++band) {
+        rows += gpaHistogram[band];
+    }
+    return rows;
+}
@@ -3,14 +3,45 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
 
 using namespace std;
 
-class StudentManager {
+// Interchangeable primary stores for the roster, keyed by student ID.
+using StudentTree = AVLTree<Student, StudentIdKey>;
+using StudentBlockStore = BlockedSortedArray<Student, StudentIdKey>;
+using StudentPersistentTree = PersistentAVLTree<Student, StudentIdKey>;
+
+// One fuzzyNameSearch() result: a matching record and its edit distance from
+// the query.
+struct NameMatch {
+    Student student;
+    int distance;
+    
+    NameMatch(const Student& s, int d) : student(s), distance(d) {}
+};
+
+// Store is the primary index policy: any container with the AVLTree
+// interface (StudentTree, StudentBlockStore, StudentPersistentTree).
+//
+// Safe for many concurrent readers alongside one writer at a time: queries
+// take rosterMutex shared, add/update/delete/undo take it exclusively.
+template <typename Store = StudentTree>
+class BasicStudentManager {
 private:
-    AVLTree<Student> studentTree;
+    Store studentTree;
+    StudentIndex studentIndex;  // secondary indexes, kept in step with studentTree
     vector<Course> courses;
     UndoManager undoManager;
+    mutable shared_mutex rosterMutex;
+    unique_ptr<ThreadPool> searchPool;     // null: full scans run on the calling thread
+    uint64_t rosterVersion;     // bumped by every change to the roster
+    mutable QueryCache queryCache;
     
  
     string studentsFilePath;
@@ -21,51 +52,166 @@ private:
     void loadStudentsFromCSV();
     void saveStudentsToCSV();
     
+    // Unlocked operations; the caller holds rosterMutex. The undo commands
+    // call the mutators from inside addStudent()/undo(), which already hold it.
+    void insertRecord(const Student& student);
+    void replaceRecord(const string& id, const Student& newData);
+    void eraseRecord(const string& id);
+    void rebuildIndexes();
+    void appendIdRange(const string& from, const string& to, vector<const Student*>& out) const;
+    void appendIdPrefix(const string& prefix, vector<const Student*>& out) const;
+    
+    // Candidate rows of one index access path, appended in the path's own
+    // order (see QueryPlanner::yieldsIdOrder).
+    void appendAccessPath(AccessPath path, const SearchCriteria& criteria,
+                          vector<const Student*>& out) const;
+    const StudentIndex::Posting* postingFor(AccessPath path, const SearchCriteria& criteria) const;
+    vector<Student> runPlan(const QueryPlan& plan, QueryStats& stats) const;
+    
+    // Calls visit(const Student&) on each match in ID order until it returns
+    // false. Paths that QueryPlanner::streams() are walked in place; the
+    // others gather their candidates first.
+    template <typename Visitor>
+    void runPlan(const QueryPlan& plan, QueryStats& stats, Visitor visit) const;
+    
 public:
-    StudentManager(const string& studentsFile, const string& coursesFile);
-    ~StudentManager();
+    BasicStudentManager(const string& studentsFile, const string& coursesFile);
+    ~BasicStudentManager();
     
  
     enum class UserType { ADMIN, STUDENT, INVALID };
-    UserType authenticate(const string& id, const string& password, Student** outStudent = nullptr);
+    UserType authenticate(const string& id, const string& password, const Student** outStudent = nullptr);
     
    
     bool addStudent(const Student& student, bool useUndo = true);
     bool updateStudent(const string& id, const Student& newData, bool useUndo = true);
     bool deleteStudent(const string& id, bool useUndo = true);
-    Student* getStudent(const string& id);
-    vector<Student> getAllStudents();
+    
+    // Returned pointers stay valid until the record is next updated or
+    // deleted; concurrent readers should use withStudent() instead.
+    const Student* getStudent(const string& id) const;
+    
+    // Runs visit(const Student&) under the read lock; false if no such ID.
+    template <typename Visitor>
+    bool withStudent(const string& id, Visitor visit) const;
+    
+    vector<Student> getAllStudents() const;
+    
+    // Direct, unlocked access for single-threaded callers.
+    const Store& getStudentStore() const { return studentTree; }
+    const StudentIndex& getStudentIndex() const { return studentIndex; }
+    
+    // Consistent point-in-time view of the roster for exports and long
+    // reports; later edits don't show up in it. O(1) on the persistent store,
+    // a full copy on the others.
+    StudentPersistentTree snapshot() const;
+    int getStudentCount() const;
+    vector<Student> getStudentsPage(int page, int pageSize) const;
+    
+    // ID range (inclusive, empty bound = open) and prefix scans on the primary index.
+    vector<Student> getStudentsInIdRange(const string& from, const string& to) const;
+    vector<Student> getStudentsWithIdPrefix(const string& prefix) const;
+    vector<Student> searchStudents(const SearchCriteria& criteria,
+                                   SearchMode mode = SearchMode::MATCH_ALL) const;
+    
+    // Searches without copying records. Matches come in ID order, skipping
+    // the first `offset` and stopping after `limit` (-1 for no limit), and
+    // the scan stops as soon as the limit is reached. Pointers are valid
+    // only until the next add/update/delete/undo.
+    vector<const Student*> searchHandles(const SearchCriteria& criteria,
+                                         SearchMode mode = SearchMode::MATCH_ALL,
+                                         int offset = 0, int limit = -1) const;
+    
+    // Streams the same matches to visit(const Student&) under the read lock;
+    // returns how many were visited.
+    template <typename Visitor>
+    int forEachMatch(const SearchCriteria& criteria, Visitor visit,
+                     SearchMode mode = SearchMode::MATCH_ALL,
+                     int offset = 0, int limit = -1) const;
+    
+    // Typo-tolerant name search: students whose first or last name is within
+    // maxDistance edits of `name` (case-insensitive), closest first, then by
+    // ID, at most `limit` of them (-1 for all). A query of two or more words
+    // is read as "first last" and the two distances are added up. Answered
+    // from the BK-trees, so only a part of the distinct names is compared.
+    vector<NameMatch> fuzzyNameSearch(const string& name, int maxDistance, int limit = -1) const;
+    
+    // Type-ahead: up to `limit` students whose ID, first name or last name
+    // starts with `prefix` (names case-insensitively). ID matches come first,
+    // then first-name and last-name matches in alphabetical order, without
+    // repeats. Costs O(log n + limit) for the IDs and O(prefix + limit) per
+    // name trie, whatever the roster size.
+    vector<Student> autocomplete(const string& prefix, int limit = 10) const;
+    
+    // Runs the search and reports the plan QueryPlanner chose for it, with
+    // the number of rows examined and matched.
+    string explain(const SearchCriteria& criteria,
+                   SearchMode mode = SearchMode::MATCH_ALL) const;
+    
+    // Runs a query written in the QueryCompiler language, e.g.
+    // "(dept=SE and year=3) or gpa>=3.9". The terms SearchCriteria can
+    // express pick the access path; the rest is checked on its candidates.
+    // Results come in ID order and are cached like searchStudents(). Returns
+    // false with a message in `error` if the query doesn't compile.
+    bool queryStudents(const string& query, vector<Student>& results, string& error) const;
+    
+    // The compiled, optimized query tree with its estimates, and the plan
+    // used for its indexable part.
+    string explainQuery(const string& query) const;
+    
+    // searchStudents() results are cached until the next add/update/delete/
+    // undo, up to `rows` cached rows in total (0 turns the cache off).
+    void setQueryCacheCapacity(size_t rows);
+    QueryCacheStats getQueryCacheStats() const;
+    
+    // Threads for searches that fall back to a full scan; 0 or 1 scans on
+    // the calling thread (the default).
+    void setSearchThreads(int threads);
+    int getSearchThreads() const;
     
    
     vector<Course> getCoursesForStudent(const string& department, int yearOfStudy);
     const vector<Course>& getAllCourses() const { return courses; }
     
    
-    bool canUndo() const { return undoManager.canUndo(); }
-    void undo() { undoManager.undo(); }
-    string getLastOperation() const { return undoManager.getLastCommandDescription(); }
+    bool canUndo() const;
+    void undo();
+    string getLastOperation() const;
     
   
     void save();
     
    
-    friend class AddStudentCommand;
-    friend class UpdateStudentCommand;
-    friend class DeleteStudentCommand;
+    friend class AddStudentCommand<BasicStudentManager>;
+    friend class UpdateStudentCommand<BasicStudentManager>;
+    friend class DeleteStudentCommand<BasicStudentManager>;
 };
 
+// Build with -DUSE_BLOCKED_STUDENT_STORE or -DUSE_PERSISTENT_STUDENT_STORE to
+// run the application on another store instead of the AVL tree.
+#if defined(USE_BLOCKED_STUDENT_STORE)
+using StudentManager = BasicStudentManager<StudentBlockStore>;
+#elif defined(USE_PERSISTENT_STUDENT_STORE)
+using StudentManager = BasicStudentManager<StudentPersistentTree>;
+#else
+using StudentManager = BasicStudentManager<StudentTree>;
+#endif
+
 
-StudentManager::StudentManager(const string& studentsFile, const string& coursesFile)
-    : studentsFilePath(studentsFile), coursesFilePath(coursesFile) {
+template <typename Store>
+BasicStudentManager<Store>::BasicStudentManager(const string& studentsFile, const string& coursesFile)
+    : rosterVersion(0), studentsFilePath(studentsFile), coursesFilePath(coursesFile) {
     loadCoursesFromCSV();
     loadStudentsFromCSV();
 }
 
-StudentManager::~StudentManager() {
+template <typename Store>
+BasicStudentManager<Store>::~BasicStudentManager() {
     save();
 }
 
-void StudentManager::loadCoursesFromCSV() {
+template <typename Store>
+void BasicStudentManager<Store>::loadCoursesFromCSV() {
     ifstream file(coursesFilePath);
     
     if (!file.is_open()) {
@@ -90,7 +236,8 @@ void StudentManager::loadCoursesFromCSV() {
     cout << "Loaded " << courses.size() << " courses from database." << endl;
 }
 
-void StudentManager::loadStudentsFromCSV() {
+template <typename Store>
+void BasicStudentManager<Store>::loadStudentsFromCSV() {
     ifstream file(studentsFilePath);
     
     if (!file.is_open()) {
@@ -99,6 +246,7 @@ void StudentManager::loadStudentsFromCSV() {
     }
     
     string line;
+    vector<Student> students;
     
     getline(file, line);
     
@@ -107,14 +255,19 @@ void StudentManager::loadStudentsFromCSV() {
         
         Student student = Student::fromCSV(line);
         if (!student.getId().empty()) {
-            studentTree.insert(student);
+            students.push_back(move(student));
         }
     }
     
+    // The file is saved in ID order, so this is normally a linear-time build.
+    studentTree.buildFrom(move(students));
+    rebuildIndexes();
+    
     cout << "Loaded " << studentTree.size() << " students from database." << endl;
 }
 
-void StudentManager::saveStudentsToCSV() {
+template <typename Store>
+void BasicStudentManager<Store>::saveStudentsToCSV() {
     ofstream file(studentsFilePath);
     
     if (!file.is_open()) {
@@ -126,24 +279,26 @@ void StudentManager::saveStudentsToCSV() {
     file << "id,password_hash,first_name,last_name,department,age,sex,year_of_study,section,course_results" << endl;
     
    
-    vector<Student> allStudents = studentTree.getAll();
-    for (const Student& student : allStudents) {
+    for (const Student& student : studentTree) {
         file << student.toCSV() << endl;
     }
     
     file.close();
-    cout << "Saved " << allStudents.size() << " students to database." << endl;
+    cout << "Saved " << studentTree.size() << " students to database." << endl;
 }
 
-StudentManager::UserType StudentManager::authenticate(const string& id, const string& password,
-                                                      Student** outStudent) {
+template <typename Store>
+typename BasicStudentManager<Store>::UserType
+BasicStudentManager<Store>::authenticate(const string& id, const string& password,
+                                         const Student** outStudent) {
    
     if (id == "admin" && password == "admin123") {
         return UserType::ADMIN;
     }
     
   
-    Student* student = getStudent(id);
+    shared_lock<shared_mutex> lock(rosterMutex);
+    const Student* student = studentTree.find(id);
     if (student && student->verifyPassword(password)) {
         if (outStudent) {
             *outStudent = student;
@@ -154,74 +309,611 @@ StudentManager::UserType StudentManager::authenticate(const string& id, const st
     return UserType::INVALID;
 }
 
-bool StudentManager::addStudent(const Student& student, bool useUndo) {
+template <typename Store>
+bool BasicStudentManager<Store>::addStudent(const Student& student, bool useUndo) {
+    unique_lock<shared_mutex> lock(rosterMutex);
 
     if (studentTree.search(student)) {
         return false;
     }
     
     if (useUndo) {
-        auto command = make_unique<AddStudentCommand>(this, student);
+        auto command = make_unique<AddStudentCommand<BasicStudentManager>>(this, student);
         undoManager.executeCommand(move(command));
     } else {
-        studentTree.insert(student);
+        insertRecord(student);
     }
     
     return true;
 }
 
-bool StudentManager::updateStudent(const string& id, const Student& newData, bool useUndo) {
-    Student searchStudent;
-    searchStudent.setId(id);
-    
-    Student* existing = studentTree.find(searchStudent);
+template <typename Store>
+bool BasicStudentManager<Store>::updateStudent(const string& id, const Student& newData, bool useUndo) {
+    unique_lock<shared_mutex> lock(rosterMutex);
+    const Student* existing = studentTree.find(id);
     if (!existing) {
         return false;
     }
     
     if (useUndo) {
         Student oldData = *existing;
-        auto command = make_unique<UpdateStudentCommand>(this, oldData, newData);
+        auto command = make_unique<UpdateStudentCommand<BasicStudentManager>>(this, oldData, newData);
         undoManager.executeCommand(move(command));
     } else {
-        studentTree.remove(*existing);
-        studentTree.insert(newData);
+        replaceRecord(id, newData);
     }
     
     return true;
 }
 
-bool StudentManager::deleteStudent(const string& id, bool useUndo) {
-    Student searchStudent;
-    searchStudent.setId(id);
-    
-    Student* existing = studentTree.find(searchStudent);
+template <typename Store>
+bool BasicStudentManager<Store>::deleteStudent(const string& id, bool useUndo) {
+    unique_lock<shared_mutex> lock(rosterMutex);
+    const Student* existing = studentTree.find(id);
     if (!existing) {
         return false;
     }
     
     if (useUndo) {
         Student studentCopy = *existing;
-        auto command = make_unique<DeleteStudentCommand>(this, studentCopy);
+        auto command = make_unique<DeleteStudentCommand<BasicStudentManager>>(this, studentCopy);
         undoManager.executeCommand(move(command));
     } else {
-        studentTree.remove(*existing);
+        eraseRecord(id);
     }
     
     return true;
 }
 
-Student* StudentManager::getStudent(const string& id) {
-    Student searchStudent;
-    searchStudent.setId(id);
-    return studentTree.find(searchStudent);
+// The secondary indexes hold pointers into the store and are keyed on the
+// record's current fields, so each mutator unindexes the old record before
+// touching the store and indexes the stored copy afterwards.
+template <typename Store>
+void BasicStudentManager<Store>::insertRecord(const Student& student) {
+    // Re-inserting under an existing ID replaces that record.
+    if (const Student* existing = studentTree.find(student.getId())) {
+        studentIndex.remove(existing);
+    }
+    
+    studentTree.insert(student);
+    studentIndex.add(studentTree.find(student.getId()));
+    rosterVersion++;
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::replaceRecord(const string& id, const Student& newData) {
+    if (newData.getId() != id) {
+        eraseRecord(id);
+    }
+    insertRecord(newData);
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::eraseRecord(const string& id) {
+    const Student* existing = studentTree.find(id);
+    if (!existing) {
+        return;
+    }
+    
+    studentIndex.remove(existing);
+    studentTree.remove(id);
+    rosterVersion++;
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::rebuildIndexes() {
+    studentIndex.clear();
+    studentIndex.addAll(studentTree);
+    rosterVersion++;
 }
 
-vector<Student> StudentManager::getAllStudents() {
+template <typename Store>
+const Student* BasicStudentManager<Store>::getStudent(const string& id) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    return studentTree.find(id);
+}
+
+template <typename Store>
+template <typename Visitor>
+bool BasicStudentManager<Store>::withStudent(const string& id, Visitor visit) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    const Student* student = studentTree.find(id);
+    if (!student) {
+        return false;
+    }
+    
+    visit(*student);
+    return true;
+}
+
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::getAllStudents() const {
+    shared_lock<shared_mutex> lock(rosterMutex);
     return studentTree.getAll();
 }
 
-vector<Course> StudentManager::getCoursesForStudent(const string& department, int yearOfStudy) {
+template <typename Store>
+int BasicStudentManager<Store>::getStudentCount() const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    return studentTree.size();
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::setQueryCacheCapacity(size_t rows) {
+    queryCache.setCapacity(rows);
+}
+
+template <typename Store>
+QueryCacheStats BasicStudentManager<Store>::getQueryCacheStats() const {
+    return queryCache.getStats();
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::setSearchThreads(int threads) {
+    unique_lock<shared_mutex> lock(rosterMutex);
+    searchPool.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+}
+
+template <typename Store>
+int BasicStudentManager<Store>::getSearchThreads() const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    return searchPool ? searchPool->size() : 1;
+}
+
+template <typename Store>
+StudentPersistentTree BasicStudentManager<Store>::snapshot() const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    if constexpr (is_same<Store, StudentPersistentTree>::value) {
+        return studentTree.snapshot();
+    } else {
+        StudentPersistentTree copy;
+        copy.buildFrom(studentTree.getAll());
+        return copy;
+    }
+}
+
+// Copies only the requested page; select() jumps straight to the first row.
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::getStudentsPage(int page, int pageSize) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    vector<Student> result;
+    const Student* first = studentTree.select(page * pageSize);
+    if (!first) {
+        return result;
+    }
+    
+    for (auto it = studentTree.lower_bound(*first);
+         it != studentTree.end() && static_cast<int>(result.size()) < pageSize; ++it) {
+        result.push_back(*it);
+    }
+    
+    return result;
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::appendIdRange(const string& from, const string& to,
+                                               vector<const Student*>& out) const {
+    if (to.empty()) {
+        for (auto it = studentTree.lower_bound(from); it != studentTree.end(); ++it) {
+            out.push_back(&*it);
+        }
+    } else {
+        studentTree.forEachInRange(from, to, [&](const Student& student) {
+            out.push_back(&student);
+        });
+    }
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::appendIdPrefix(const string& prefix,
+                                                vector<const Student*>& out) const {
+    studentTree.forEachWithPrefix(prefix, [&](const Student& student) {
+        out.push_back(&student);
+    });
+}
+
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::getStudentsInIdRange(const string& from, const string& to) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    vector<const Student*> matches;
+    appendIdRange(from, to, matches);
+    
+    vector<Student> result;
+    result.reserve(matches.size());
+    for (const Student* student : matches) {
+        result.push_back(*student);
+    }
+    return result;
+}
+
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::getStudentsWithIdPrefix(const string& prefix) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    vector<const Student*> matches;
+    appendIdPrefix(prefix, matches);
+    
+    vector<Student> result;
+    result.reserve(matches.size());
+    for (const Student* student : matches) {
+        result.push_back(*student);
+    }
+    return result;
+}
+
+// The ID-ordered posting list behind a secondary-index path, or nullptr.
+template <typename Store>
+const StudentIndex::Posting* BasicStudentManager<Store>::postingFor(AccessPath path,
+                                                                   const SearchCriteria& criteria) const {
+    switch (path) {
+        case AccessPath::COHORT:
+            return &studentIndex.withCohort(criteria.department, criteria.yearOfStudy,
+                                            criteria.section);
+        case AccessPath::DEPARTMENT:
+            return &studentIndex.withDepartment(criteria.department);
+        case AccessPath::SECTION:
+            return &studentIndex.withSection(criteria.section);
+        case AccessPath::YEAR_OF_STUDY:
+            return &studentIndex.withYear(criteria.yearOfStudy);
+        default:
+            return nullptr;
+    }
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::appendAccessPath(AccessPath path, const SearchCriteria& criteria,
+                                                  vector<const Student*>& out) const {
+    if (const StudentIndex::Posting* posting = postingFor(path, criteria)) {
+        out.insert(out.end(), posting->begin(), posting->end());
+        return;
+    }
+    
+    switch (path) {
+        case AccessPath::ID_LOOKUP:
+            if (const Student* student = studentTree.find(criteria.id)) {
+                out.push_back(student);
+            }
+            break;
+        case AccessPath::ID_PREFIX:
+            appendIdPrefix(criteria.idPrefix, out);
+            break;
+        case AccessPath::ID_RANGE:
+            appendIdRange(criteria.idFrom, criteria.idTo, out);
+            break;
+        case AccessPath::GPA_RANGE:
+            studentIndex.forEachInGpaRange(criteria.minGPA, criteria.maxGPA,
+                                           [&](const Student* student) { out.push_back(student); });
+            break;
+        case AccessPath::FIRST_NAME: {
+            vector<const Student*> matches = studentIndex.firstNameTrigrams().candidates(criteria.firstName);
+            out.insert(out.end(), matches.begin(), matches.end());
+            break;
+        }
+        case AccessPath::LAST_NAME: {
+            vector<const Student*> matches = studentIndex.lastNameTrigrams().candidates(criteria.lastName);
+            out.insert(out.end(), matches.begin(), matches.end());
+            break;
+        }
+        case AccessPath::COHORT:
+        case AccessPath::DEPARTMENT:
+        case AccessPath::SECTION:
+        case AccessPath::YEAR_OF_STUDY:
+        case AccessPath::FULL_SCAN:
+        case AccessPath::INDEX_UNION:
+        case AccessPath::BITMAP:
+        case AccessPath::COLUMN_SCAN:
+            break;
+    }
+}
+
+// Results always come back in ID order, whatever the access path.
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::runPlan(const QueryPlan& plan, QueryStats& stats) const {
+    vector<Student> results;
+    
+    if (plan.access == AccessPath::FULL_SCAN && searchPool) {
+        results = SearchManager::parallelFilter(studentTree, [&](const Student& student) {
+            return plan.matches(student);
+        }, *searchPool);
+        stats.rowsExamined = studentTree.size();
+        stats.rowsMatched = results.size();
+    } else {
+        runPlan(plan, stats, [&](const Student& student) {
+            results.push_back(student);
+            return true;
+        });
+    }
+    
+    return results;
+}
+
+template <typename Store>
+template <typename Visitor>
+void BasicStudentManager<Store>::runPlan(const QueryPlan& plan, QueryStats& stats,
+                                         Visitor visit) const {
+    auto examine = [&](const Student& student) {
+        stats.rowsExamined++;
+        if (!plan.matches(student)) {
+            return true;
+        }
+        stats.rowsMatched++;
+        return visit(student);
+    };
+    
+    const SearchCriteria& criteria = plan.criteria;
+    
+    if (plan.access == AccessPath::FULL_SCAN) {
+        for (const Student& student : studentTree) {
+            if (!examine(student)) return;
+        }
+    } else if (plan.access == AccessPath::ID_RANGE) {
+        if (!criteria.idTo.empty() && criteria.idFrom > criteria.idTo) {
+            return;
+        }
+        auto it = criteria.idFrom.empty() ? studentTree.begin() : studentTree.lower_bound(criteria.idFrom);
+        auto end = criteria.idTo.empty() ? studentTree.end() : studentTree.upper_bound(criteria.idTo);
+        for (; it != end; ++it) {
+            if (!examine(*it)) return;
+        }
+    } else if (plan.access == AccessPath::ID_PREFIX) {
+        for (auto it = studentTree.lower_bound(criteria.idPrefix);
+             it != studentTree.end() && it->getId().compare(0, criteria.idPrefix.size(), criteria.idPrefix) == 0;
+             ++it) {
+            if (!examine(*it)) return;
+        }
+    } else if (const StudentIndex::Posting* posting = postingFor(plan.access, criteria)) {
+        for (const Student* student : *posting) {
+            if (!examine(*student)) return;
+        }
+    } else {
+        vector<const Student*> candidates;
+        if (plan.access == AccessPath::INDEX_UNION) {
+            for (AccessPath path : plan.unionPaths) {
+                appendAccessPath(path, criteria, candidates);
+            }
+            sort(candidates.begin(), candidates.end(), StudentPtrIdLess());
+            candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+        } else if (plan.access == AccessPath::BITMAP) {
+            studentIndex.columns().selectByBitmaps(criteria, plan.mode, candidates);
+        } else if (plan.access == AccessPath::COLUMN_SCAN) {
+            studentIndex.columns().select(criteria, plan.mode, candidates);
+        } else {
+            appendAccessPath(plan.access, criteria, candidates);
+            if (!QueryPlanner::yieldsIdOrder(plan.access)) {
+                sort(candidates.begin(), candidates.end(), StudentPtrIdLess());
+            }
+        }
+        
+        for (const Student* student : candidates) {
+            if (!examine(*student)) return;
+        }
+    }
+}
+
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::searchStudents(const SearchCriteria& criteria,
+                                               SearchMode mode) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    string key = QueryCache::keyFor(criteria, mode);
+    if (auto cached = queryCache.lookup(key, rosterVersion)) {
+        return *cached;
+    }
+    
+    QueryStats stats;
+    vector<Student> results = runPlan(QueryPlanner::plan(criteria, mode, studentTree, studentIndex), stats);
+    queryCache.store(key, rosterVersion, results);
+    return results;
+}
+
+template <typename Store>
+vector<const Student*> BasicStudentManager<Store>::searchHandles(const SearchCriteria& criteria,
+                                                                SearchMode mode, int offset,
+                                                                int limit) const {
+    vector<const Student*> handles;
+    if (limit > 0) {
+        handles.reserve(limit);
+    }
+    forEachMatch(criteria, [&](const Student& student) { handles.push_back(&student); },
+                 mode, offset, limit);
+    return handles;
+}
+
+template <typename Store>
+template <typename Visitor>
+int BasicStudentManager<Store>::forEachMatch(const SearchCriteria& criteria, Visitor visit,
+                                             SearchMode mode, int offset, int limit) const {
+    if (limit == 0) {
+        return 0;
+    }
+    
+    shared_lock<shared_mutex> lock(rosterMutex);
+    QueryStats stats;
+    int skipped = 0;
+    int visited = 0;
+    int rowLimit = limit < 0 ? -1 : offset + limit;
+    runPlan(QueryPlanner::plan(criteria, mode, studentTree, studentIndex, rowLimit), stats,
+            [&](const Student& student) {
+                if (skipped < offset) {
+                    skipped++;
+                    return true;
+                }
+                visit(student);
+                visited++;
+                return limit < 0 || visited < limit;
+            });
+    return visited;
+}
+
+template <typename Store>
+vector<NameMatch> BasicStudentManager<Store>::fuzzyNameSearch(const string& name, int maxDistance,
+                                                             int limit) const {
+    vector<string> words;
+    for (const string& word : Utils::split(name, ' ')) {
+        if (!word.empty()) words.push_back(word);
+    }
+    if (words.empty() || limit == 0) {
+        return {};
+    }
+    
+    shared_lock<shared_mutex> lock(rosterMutex);
+    unordered_map<const Student*, int> closest;
+    if (words.size() == 1) {
+        auto keepClosest = [&](const Student* student, int distance) {
+            auto found = closest.find(student);
+            if (found == closest.end() || distance < found->second) {
+                closest[student] = distance;
+            }
+        };
+        studentIndex.firstNameTree().forEachWithin(words[0], maxDistance, keepClosest);
+        studentIndex.lastNameTree().forEachWithin(words[0], maxDistance, keepClosest);
+    } else {
+        unordered_map<const Student*, int> firstDistance;
+        studentIndex.firstNameTree().forEachWithin(words.front(), maxDistance,
+            [&](const Student* student, int distance) { firstDistance[student] = distance; });
+        studentIndex.lastNameTree().forEachWithin(words.back(), maxDistance,
+            [&](const Student* student, int distance) {
+                auto found = firstDistance.find(student);
+                if (found != firstDistance.end() && found->second + distance <= maxDistance) {
+                    closest[student] = found->second + distance;
+                }
+            });
+    }
+    
+    vector<pair<int, const Student*>> ranked;
+    ranked.reserve(closest.size());
+    for (const auto& entry : closest) {
+        ranked.emplace_back(entry.second, entry.first);
+    }
+    sort(ranked.begin(), ranked.end(), [](const pair<int, const Student*>& a,
+                                          const pair<int, const Student*>& b) {
+        if (a.first != b.first) {
+            return a.first < b.first;
+        }
+        return a.second->getId() < b.second->getId();
+    });
+    if (limit > 0 && ranked.size() > static_cast<size_t>(limit)) {
+        ranked.resize(limit);
+    }
+    
+    vector<NameMatch> matches;
+    matches.reserve(ranked.size());
+    for (const auto& entry : ranked) {
+        matches.emplace_back(*entry.second, entry.first);
+    }
+    return matches;
+}
+
+template <typename Store>
+vector<Student> BasicStudentManager<Store>::autocomplete(const string& prefix, int limit) const {
+    vector<Student> suggestions;
+    if (prefix.empty() || limit <= 0) {
+        return suggestions;
+    }
+    
+    shared_lock<shared_mutex> lock(rosterMutex);
+    vector<const Student*> picked;
+    picked.reserve(limit);
+    auto pick = [&](const Student* student) {
+        if (static_cast<int>(picked.size()) < limit &&
+            find(picked.begin(), picked.end(), student) == picked.end()) {
+            picked.push_back(student);
+        }
+        return static_cast<int>(picked.size()) < limit;
+    };
+    
+    studentTree.forEachWithPrefix(prefix, [&](const Student& student) { return pick(&student); });
+    // Each trie is asked for a full `limit`, since some of its records may
+    // already have been picked.
+    studentIndex.firstNameTrie().forEachWithPrefix(prefix, limit, pick);
+    studentIndex.lastNameTrie().forEachWithPrefix(prefix, limit, pick);
+    
+    suggestions.reserve(picked.size());
+    for (const Student* student : picked) {
+        suggestions.push_back(*student);
+    }
+    return suggestions;
+}
+
+template <typename Store>
+string BasicStudentManager<Store>::explain(const SearchCriteria& criteria, SearchMode mode) const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    QueryPlan plan = QueryPlanner::plan(criteria, mode, studentTree, studentIndex);
+    QueryStats stats;
+    runPlan(plan, stats);
+    
+    return plan.describe() + "Rows examined: " + to_string(stats.rowsExamined) +
+           ", matched: " + to_string(stats.rowsMatched) + "\n";
+}
+
+template <typename Store>
+bool BasicStudentManager<Store>::queryStudents(const string& query, vector<Student>& results,
+                                               string& error) const {
+    QueryNode root;
+    if (!QueryCompiler::compile(query, root, error)) {
+        return false;
+    }
+    
+    shared_lock<shared_mutex> lock(rosterMutex);
+    string key = "?" + root.toString();
+    if (auto cached = queryCache.lookup(key, rosterVersion)) {
+        results = *cached;
+        return true;
+    }
+    
+    results.clear();
+    if (root.kind == QueryNode::Kind::CONSTANT) {
+        if (root.value) {
+            results = studentTree.getAll();
+        }
+    } else {
+        QueryCompiler::optimize(root, studentTree, studentIndex);
+        QueryPlan plan = QueryPlanner::plan(QueryCompiler::pushdownCriteria(root), SearchMode::MATCH_ALL,
+                                            studentTree, studentIndex);
+        
+        if (plan.access == AccessPath::FULL_SCAN && searchPool) {
+            results = SearchManager::parallelFilter(studentTree, [&](const Student& student) {
+                return root.matches(student);
+            }, *searchPool);
+        } else {
+            QueryStats stats;
+            runPlan(plan, stats, [&](const Student& student) {
+                if (root.matches(student)) {
+                    results.push_back(student);
+                }
+                return true;
+            });
+        }
+    }
+    
+    queryCache.store(key, rosterVersion, results);
+    return true;
+}
+
+template <typename Store>
+string BasicStudentManager<Store>::explainQuery(const string& query) const {
+    QueryNode root;
+    string error;
+    if (!QueryCompiler::compile(query, root, error)) {
+        return "Query error: " + error + "\n";
+    }
+    
+    shared_lock<shared_mutex> lock(rosterMutex);
+    QueryCompiler::optimize(root, studentTree, studentIndex);
+    QueryPlan plan = QueryPlanner::plan(QueryCompiler::pushdownCriteria(root), SearchMode::MATCH_ALL,
+                                        studentTree, studentIndex);
+    
+    size_t matched = 0;
+    QueryStats stats;
+    runPlan(plan, stats, [&](const Student& student) {
+        matched += root.matches(student) ? 1 : 0;
+        return true;
+    });
+    
+    return QueryCompiler::explain(root) + plan.describe() + "Rows examined: " +
+           to_string(stats.rowsExamined) + ", matched: " + to_string(matched) + "\n";
+}
+
+template <typename Store>
+vector<Course> BasicStudentManager<Store>::getCoursesForStudent(const string& department, int yearOfStudy) {
     vector<Course> result;
     
     for (const Course& course : courses) {
@@ -233,72 +925,104 @@ vector<Course> StudentManager::getCoursesForStudent(const string& department, in
     return result;
 }
 
-void StudentManager::save() {
+template <typename Store>
+bool BasicStudentManager<Store>::canUndo() const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    return undoManager.canUndo();
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::undo() {
+    unique_lock<shared_mutex> lock(rosterMutex);
+    undoManager.undo();
+}
+
+template <typename Store>
+string BasicStudentManager<Store>::getLastOperation() const {
+    shared_lock<shared_mutex> lock(rosterMutex);
+    return undoManager.getLastCommandDescription();
+}
+
+template <typename Store>
+void BasicStudentManager<Store>::save() {
+    shared_lock<shared_mutex> lock(rosterMutex);
     saveStudentsToCSV();
 }
 
 
-AddStudentCommand::AddStudentCommand(StudentManager* mgr, const Student& s)
+template <typename Manager>
+AddStudentCommand<Manager>::AddStudentCommand(Manager* mgr, const Student& s)
     : manager(mgr), student(s), executed(false) {}
 
-void AddStudentCommand::execute() {
+template <typename Manager>
+void AddStudentCommand<Manager>::execute() {
     if (!executed) {
-        manager->addStudent(student, false);  // Don't use undo for undo commands
+        manager->insertRecord(student);  // Don't use undo for undo commands
         executed = true;
     }
 }
 
-void AddStudentCommand::undo() {
+template <typename Manager>
+void AddStudentCommand<Manager>::undo() {
     if (executed) {
-        manager->deleteStudent(student.getId(), false);
+        manager->eraseRecord(student.getId());
         executed = false;
     }
 }
 
-string AddStudentCommand::getDescription() const {
+template <typename Manager>
+string AddStudentCommand<Manager>::getDescription() const {
     return "Add student: " + student.getId() + " (" + student.getFullName() + ")";
 }
 
 
-UpdateStudentCommand::UpdateStudentCommand(StudentManager* mgr, const Student& oldS, const Student& newS)
+template <typename Manager>
+UpdateStudentCommand<Manager>::UpdateStudentCommand(Manager* mgr, const Student& oldS, const Student& newS)
     : manager(mgr), oldStudent(oldS), newStudent(newS), executed(false) {}
 
-void UpdateStudentCommand::execute() {
+template <typename Manager>
+void UpdateStudentCommand<Manager>::execute() {
     if (!executed) {
-        manager->updateStudent(newStudent.getId(), newStudent, false);
+        manager->replaceRecord(oldStudent.getId(), newStudent);
         executed = true;
     }
 }
 
-void UpdateStudentCommand::undo() {
+template <typename Manager>
+void UpdateStudentCommand<Manager>::undo() {
     if (executed) {
-        manager->updateStudent(oldStudent.getId(), oldStudent, false);
+        manager->replaceRecord(newStudent.getId(), oldStudent);
         executed = false;
     }
 }
 
-string UpdateStudentCommand::getDescription() const {
+template <typename Manager>
+string UpdateStudentCommand<Manager>::getDescription() const {
     return "Update student: " + newStudent.getId() + " (" + newStudent.getFullName() + ")";
 }
 
-DeleteStudentCommand::DeleteStudentCommand(StudentManager* mgr, const Student& s)
+template <typename Manager>
+DeleteStudentCommand<Manager>::DeleteStudentCommand(Manager* mgr, const Student& s)
     : manager(mgr), student(s), executed(false) {}
 
-void DeleteStudentCommand::execute() {
+template <typename Manager>
+void DeleteStudentCommand<Manager>::execute() {
     if (!executed) {
-        manager->deleteStudent(student.getId(), false);
+        manager->eraseRecord(student.getId());
         executed = true;
     }
 }
 
-void DeleteStudentCommand::undo() {
+template <typename Manager>
+void DeleteStudentCommand<Manager>::undo() {
     if (executed) {
-        manager->addStudent(student, false);
+        manager->insertRecord(student);
         executed = false;
     }
 }
 
-string DeleteStudentCommand::getDescription() const {
+template <typename Manager>
+string DeleteStudentCommand<Manager>::getDescription() const {
     return "Delete student: " + student.getId() + " (" + student.getFullName() + ")";
 }
 
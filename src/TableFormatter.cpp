@@ -12,12 +12,18 @@ public:
     static void displayStudent(const Student& student);
     
    
-    static void displayStudents(const vector<Student>& students);
+    // Works on any range of students, so the student tree can be printed
+    // without copying it into a vector first.
+    template <typename Range>
+    static void displayStudents(const Range& students);
 
     static void displayStudentDetailed(const Student& student);
     
 private:
     
+    static void printTableHeader();
+    static void printStudentRow(const Student& student);
+    static void printTableFooter(size_t count);
     static void printHorizontalLine(const vector<int>& columnWidths);
     static void printRow(const vector<string>& values,
                         const vector<int>& columnWidths);
@@ -25,49 +31,63 @@ private:
     static string padRight(const string& text, int width);
 };
 
+static const vector<int> STUDENT_TABLE_WIDTHS = {8, 25, 8, 5, 5, 6, 8, 6};
+
 void TableFormatter::displayStudent(const Student& student) {
-    displayStudents({student});
+    printTableHeader();
+    printStudentRow(student);
+    printTableFooter(1);
 }
 
-void TableFormatter::displayStudents(const vector<Student>& students) {
-    if (students.empty()) {
+template <typename Range>
+void TableFormatter::displayStudents(const Range& students) {
+    if (begin(students) == end(students)) {
         cout << "\nNo students to display.\n" << endl;
         return;
     }
     
+    printTableHeader();
     
+    size_t count = 0;
+    for (const Student& student : students) {
+        printStudentRow(student);
+        count++;
+    }
+    
+    printTableFooter(count);
+}
+
+void TableFormatter::printTableHeader() {
     vector<string> headers = {
         "ID", "Name", "Dept", "Age", "Sex", "Year", "Section", "GPA"
     };
     
-    vector<int> widths = {8, 25, 8, 5, 5, 6, 8, 6};
+    printHorizontalLine(STUDENT_TABLE_WIDTHS);
+    printRow(headers, STUDENT_TABLE_WIDTHS);
+    printHorizontalLine(STUDENT_TABLE_WIDTHS);
+}
+
+void TableFormatter::printStudentRow(const Student& student) {
+    vector<string> row;
     
-   
-    printHorizontalLine(widths);
-    printRow(headers, widths);
-    printHorizontalLine(widths);
+    row.push_back(student.getId());
+    row.push_back(student.getFullName());
+    row.push_back(student.getDepartment());
+    row.push_back(to_string(student.getAge()));
+    row.push_back(string(1, student.getSex()));
+    row.push_back(to_string(student.getYearOfStudy()));
+    row.push_back(student.getSection());
     
-
-    for (const Student& student : students) {
-        vector<string> row;
-        
-        row.push_back(student.getId());
-        row.push_back(student.getFullName());
-        row.push_back(student.getDepartment());
-        row.push_back(to_string(student.getAge()));
-        row.push_back(string(1, student.getSex()));
-        row.push_back(to_string(student.getYearOfStudy()));
-        row.push_back(student.getSection());
-        
-        stringstream gpaStream;
-        gpaStream << fixed << setprecision(2) << student.getGPA();
-        row.push_back(gpaStream.str());
-        
-        printRow(row, widths);
-    }
+    stringstream gpaStream;
+    gpaStream << fixed << setprecision(2) << student.getGPA();
+    row.push_back(gpaStream.str());
     
-    printHorizontalLine(widths);
-    cout << "Total: " << students.size() << " student(s)\n" << endl;
+    printRow(row, STUDENT_TABLE_WIDTHS);
+}
+
+void TableFormatter::printTableFooter(size_t count) {
+    printHorizontalLine(STUDENT_TABLE_WIDTHS);
+    cout << "Total: " << count << " student(s)\n" << endl;
 }
 
 void TableFormatter::displayStudentDetailed(const Student& student) {
@@ -0,0 +1,94 @@
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+using namespace std;
+
+// Fixed set of worker threads fed from one FIFO task queue. submit() may be
+// called from any thread, including several at once; the destructor finishes
+// the queued tasks and joins the workers.
+class ThreadPool {
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable taskReady;
+    bool stopping;
+    
+    void workerLoop();
+
+public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    size_t size() const { return workers.size(); }
+    
+    // Queues `task`; the future yields its result or rethrows its exception.
+    template <typename Fn>
+    future<invoke_result_t<Fn>> submit(Fn task);
+    
+    // Worker count for "use the whole machine"; at least 1.
+    static size_t defaultThreadCount();
+};
+
+
+ThreadPool::ThreadPool(size_t threadCount) : stopping(false) {
+    threadCount = max<size_t>(1, threadCount);
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+template <typename Fn>
+future<invoke_result_t<Fn>> ThreadPool::submit(Fn task) {
+    // function<> needs a copyable callable, so the packaged_task is shared.
+    auto packaged = make_shared<packaged_task<invoke_result_t<Fn>()>>(move(task));
+    future<invoke_result_t<Fn>> result = packaged->get_future();
+    {
+        lock_guard<mutex> lock(queueMutex);
+        tasks.emplace([packaged] { (*packaged)(); });
+    }
+    taskReady.notify_one();
+    return result;
+}
+
+size_t ThreadPool::defaultThreadCount() {
+    return max(1u, thread::hardware_concurrency());
+}
@@ -0,0 +1,135 @@
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+// Trigram inverted index for substring search over one case-folded text field
+// (a first or last name). Every record is listed under each distinct
+// three-character window of its text, so any record containing a query of
+// three or more characters appears in all of the query's postings. Posting
+// lists are vectors sorted by address, so intersecting them never touches the
+// records; the caller checks the surviving candidates against the query.
+class TrigramIndex {
+public:
+    static constexpr size_t MIN_QUERY_LENGTH = 3;
+
+private:
+    using Posting = vector<const Student*>;
+    
+    unordered_map<uint32_t, Posting> postings;
+    
+    static vector<uint32_t> trigramsOf(const string& foldedText);
+
+public:
+    void add(const Student* student, const string& foldedText);
+    
+    // Bulk loading: append() lists a record without keeping the postings
+    // sorted, and sortAppended() sorts them all once afterwards. No query,
+    // add() or remove() may run in between.
+    void append(const Student* student, const string& foldedText);
+    void sortAppended();
+    void remove(const Student* student, const string& foldedText);
+    void clear() { postings.clear(); }
+    
+    // Upper bound on the candidates for `needle`: its smallest posting list.
+    // Only meaningful for needles of at least MIN_QUERY_LENGTH characters.
+    size_t estimate(const string& needle) const;
+    
+    // Records whose text has every trigram of `needle` (case-insensitive), in
+    // address order. Needles shorter than MIN_QUERY_LENGTH give nothing.
+    vector<const Student*> candidates(const string& needle) const;
+};
+
+
+vector<uint32_t> TrigramIndex::trigramsOf(const string& foldedText) {
+    vector<uint32_t> grams;
+    for (size_t i = 0; i + 3 <= foldedText.size(); ++i) {
+        grams.push_back(static_cast<unsigned char>(foldedText[i]) << 16 |
+                        static_cast<unsigned char>(foldedText[i + 1]) << 8 |
+                        static_cast<unsigned char>(foldedText[i + 2]));
+    }
+    
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void TrigramIndex::add(const Student* student, const string& foldedText) {
+    for (uint32_t gram : trigramsOf(foldedText)) {
+        Posting& posting = postings[gram];
+        posting.insert(lower_bound(posting.begin(), posting.end(), student, less<const Student*>()),
+                       student);
+    }
+}
+
+void TrigramIndex::append(const Student* student, const string& foldedText) {
+    for (uint32_t gram : trigramsOf(foldedText)) {
+        postings[gram].push_back(student);
+    }
+}
+
+void TrigramIndex::sortAppended() {
+    for (auto& entry : postings) {
+        sort(entry.second.begin(), entry.second.end(), less<const Student*>());
+    }
+}
+
+void TrigramIndex::remove(const Student* student, const string& foldedText) {
+    for (uint32_t gram : trigramsOf(foldedText)) {
+        auto it = postings.find(gram);
+        if (it == postings.end()) continue;
+        
+        Posting& posting = it->second;
+        auto pos = lower_bound(posting.begin(), posting.end(), student, less<const Student*>());
+        if (pos != posting.end() && *pos == student) {
+            posting.erase(pos);
+        }
+        if (posting.empty()) {
+            postings.erase(it);
+        }
+    }
+}
+
+size_t TrigramIndex::estimate(const string& needle) const {
+    size_t smallest = SIZE_MAX;
+    for (uint32_t gram : trigramsOf(Utils::toLower(needle))) {
+        auto it = postings.find(gram);
+        smallest = min(smallest, it == postings.end() ? size_t(0) : it->second.size());
+    }
+    return smallest == SIZE_MAX ? 0 : smallest;
+}
+
+vector<const Student*> TrigramIndex::candidates(const string& needle) const {
+    vector<const Posting*> lists;
+    for (uint32_t gram : trigramsOf(Utils::toLower(needle))) {
+        auto it = postings.find(gram);
+        if (it == postings.end()) {
+            return {};
+        }
+        lists.push_back(&it->second);
+    }
+    
+    if (lists.empty()) {
+        return {};
+    }
+    
+    // Start from the shortest list so every intermediate result stays small.
+    sort(lists.begin(), lists.end(), [](const Posting* a, const Posting* b) {
+        return a->size() < b->size();
+    });
+    
+    vector<const Student*> result = *lists[0];
+    vector<const Student*> narrowed;
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        narrowed.clear();
+        set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                         back_inserter(narrowed), less<const Student*>());
+        result.swap(narrowed);
+    }
+    
+    return result;
+}
@@ -5,9 +5,6 @@
 using namespace std;
 
 
-class StudentManager;
-
-
 class Command {
 public:
     virtual ~Command() = default;
@@ -17,43 +14,46 @@ public:
 };
 
 
+template <typename Manager>
 class AddStudentCommand : public Command {
 private:
-    StudentManager* manager;
+    Manager* manager;
     Student student;
     bool executed;
     
 public:
-    AddStudentCommand(StudentManager* mgr, const Student& s);
+    AddStudentCommand(Manager* mgr, const Student& s);
     void execute() override;
     void undo() override;
     string getDescription() const override;
 };
 
 
+template <typename Manager>
 class UpdateStudentCommand : public Command {
 private:
-    StudentManager* manager;
+    Manager* manager;
     Student oldStudent;
     Student newStudent;
     bool executed;
     
 public:
-    UpdateStudentCommand(StudentManager* mgr, const Student& oldS, const Student& newS);
+    UpdateStudentCommand(Manager* mgr, const Student& oldS, const Student& newS);
     void execute() override;
     void undo() override;
     string getDescription() const override;
 };
 
 
+template <typename Manager>
 class DeleteStudentCommand : public Command {
 private:
-    StudentManager* manager;
+    Manager* manager;
     Student student;
     bool executed;
     
 public:
-    DeleteStudentCommand(StudentManager* mgr, const Student& s);
+    DeleteStudentCommand(Manager* mgr, const Student& s);
     void execute() override;
     void undo() override;
     string getDescription() const override;
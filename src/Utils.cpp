@@ -14,6 +14,14 @@ namespace Utils {
     vector<string> split(const string& str, char delimiter);
     string join(const vector<string>& vec, const string& delimiter);
     
+    // ASCII case folding, used for name keys and name searches.
+    string toLower(const string& str);
+    bool containsFolded(const string& foldedText, const string& needle);
+    
+    // Levenshtein distance: single-character insertions, deletions and
+    // substitutions needed to turn one string into the other.
+    int editDistance(const string& a, const string& b);
+    
 
     bool isValidAge(int age);
     bool isValidGPA(double gpa);
@@ -39,6 +47,48 @@ namespace Utils {
         return str.substr(start, end - start + 1);
     }
     
+    string toLower(const string& str) {
+        string result = str;
+        transform(result.begin(), result.end(), result.begin(),
+                  [](unsigned char c) { return tolower(c); });
+        return result;
+    }
+    
+    // Case-insensitive substring test against text that is already folded;
+    // folds the needle a character at a time instead of copying it.
+    bool containsFolded(const string& foldedText, const string& needle) {
+        if (needle.size() > foldedText.size()) return false;
+        
+        for (size_t start = 0; start + needle.size() <= foldedText.size(); ++start) {
+            size_t i = 0;
+            while (i < needle.size() &&
+                   foldedText[start + i] == tolower(static_cast<unsigned char>(needle[i]))) {
+                ++i;
+            }
+            if (i == needle.size()) return true;
+        }
+        
+        return false;
+    }
+    
+    // Two-row dynamic program, O(|a|*|b|) time and O(|b|) space.
+    int editDistance(const string& a, const string& b) {
+        vector<int> previous(b.size() + 1);
+        vector<int> current(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) previous[j] = j;
+        
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = i;
+            for (size_t j = 1; j <= b.size(); ++j) {
+                int substitution = previous[j - 1] + (a[i - 1] != b[j - 1]);
+                current[j] = min({previous[j] + 1, current[j - 1] + 1, substitution});
+            }
+            previous.swap(current);
+        }
+        
+        return previous[b.size()];
+    }
+    
     vector<string> split(const string& str, char delimiter) {
         vector<string> tokens;
         stringstream ss(str);
@@ -13,12 +13,25 @@ using namespace std;
 
 #include "Utils.cpp"
 #include "Course.cpp"
+#include "PoolAllocator.cpp"
 #include "AVLTree.cpp"
+#include "BlockedSortedArray.cpp"
+#include "PersistentAVLTree.cpp"
 #include "Student.cpp"
 #include "UndoManager.cpp"
+#include "ThreadPool.cpp"
 #include "Grader.cpp"
 #include "Sorter.cpp"
 #include "SearchManager.cpp"
+#include "TrigramIndex.cpp"
+#include "BKTree.cpp"
+#include "RadixTrie.cpp"
+#include "RowBitmap.cpp"
+#include "StudentColumns.cpp"
+#include "StudentIndex.cpp"
+#include "QueryPlanner.cpp"
+#include "QueryCompiler.cpp"
+#include "QueryCache.cpp"
 #include "TableFormatter.cpp"
 #include "StudentManager.cpp"
 
@@ -36,7 +49,7 @@ void pause() {
 }
 
 void adminMenu(StudentManager& manager);
-void studentMenu(StudentManager& manager, Student* student);
+void studentMenu(StudentManager& manager, const Student* student);
 
 void addStudentMenu(StudentManager& manager);
 void updateStudentMenu(StudentManager& manager);
@@ -54,6 +67,8 @@ int main() {
     cout << "\nInitializing system..." << endl;
     
     StudentManager manager("data/students.csv", "data/courses.csv");
+    manager.setSearchThreads(ThreadPool::defaultThreadCount());
+    Sorter::setThreadCount(ThreadPool::defaultThreadCount());
     
     cout << "\nSystem ready!\n" << endl;
     
@@ -80,7 +95,7 @@ int main() {
         cout << "Enter Password: ";
         string password = Utils::getLine();
         
-        Student* student = nullptr;
+        const Student* student = nullptr;
         StudentManager::UserType userType = manager.authenticate(id, password, &student);
         
         if (userType == StudentManager::UserType::ADMIN) {
@@ -132,7 +147,7 @@ void adminMenu(StudentManager& manager) {
     }
 }
 
-void studentMenu(StudentManager& manager, Student* student) {
+void studentMenu(StudentManager& manager, const Student* student) {
     while (true) {
         clearScreen();
         cout << "╔════════════════════════════════════════════════════════════════╗" << endl;
@@ -247,7 +262,7 @@ void updateStudentMenu(StudentManager& manager) {
     cout << "\nEnter Student ID: ";
     string id = Utils::getLine();
     
-    Student* student = manager.getStudent(id);
+    const Student* student = manager.getStudent(id);
     if (!student) {
         cout << "\n Student not found!" << endl;
         pause();
@@ -315,7 +330,7 @@ void deleteStudentMenu(StudentManager& manager) {
     cout << "\nEnter Student ID: ";
     string id = Utils::getLine();
     
-    Student* student = manager.getStudent(id);
+    const Student* student = manager.getStudent(id);
     if (!student) {
         cout << "\nStudent not found!" << endl;
         pause();
@@ -349,10 +364,35 @@ void searchStudentMenu(StudentManager& manager) {
     SearchCriteria criteria;
     
     cout << "\nEnter search criteria (press Enter to skip):" << endl;
+    cout << "(Or type a whole query at the ID prompt, e.g. (dept=SE and year=3) or SWEG3103.grade=A)" << endl;
     
-    cout << "Student ID: ";
+    cout << "Student ID (exact, prefix* or from..to): ";
     string id = Utils::getLine();
-    if (!id.empty()) criteria.id = id;
+    
+    // Comparison operators or parentheses mean a query rather than an ID.
+    if (id.find_first_of("=<>~!()") != string::npos) {
+        vector<Student> results;
+        string error;
+        clearScreen();
+        if (manager.queryStudents(id, results, error)) {
+            cout << "\nQuery Results:" << endl;
+            TableFormatter::displayStudents(results);
+        } else {
+            cout << "\nQuery error: " << error << endl;
+        }
+        pause();
+        return;
+    }
+    
+    size_t rangePos = id.find("..");
+    if (rangePos != string::npos) {
+        criteria.idFrom = id.substr(0, rangePos);
+        criteria.idTo = id.substr(rangePos + 2);
+    } else if (!id.empty() && id.back() == '*') {
+        criteria.idPrefix = id.substr(0, id.size() - 1);
+    } else if (!id.empty()) {
+        criteria.id = id;
+    }
     
     cout << "First Name: ";
     string firstName = Utils::getLine();
@@ -366,6 +406,10 @@ void searchStudentMenu(StudentManager& manager) {
     string dept = Utils::getLine();
     if (!dept.empty()) criteria.department = dept;
     
+    cout << "Section: ";
+    string section = Utils::getLine();
+    if (!section.empty()) criteria.section = section;
+    
     cout << "Age (0 to skip): ";
     int age = Utils::getInt();
     if (age > 0) criteria.age = age;
@@ -394,13 +438,27 @@ void searchStudentMenu(StudentManager& manager) {
     
     SearchMode mode = (modeChoice == 2) ? SearchMode::MATCH_ANY : SearchMode::MATCH_ALL;
     
-    vector<Student> allStudents = manager.getAllStudents();
-    vector<Student> results = SearchManager::search(allStudents, criteria, mode);
+    vector<Student> results = manager.searchStudents(criteria, mode);
     
     clearScreen();
     cout << "\nSearch Results:" << endl;
     TableFormatter::displayStudents(results);
     
+    // Nothing matched a name as typed: suggest names a few typos away, allowing
+    // more typos for longer names.
+    string name = Utils::trim(criteria.firstName + " " + criteria.lastName);
+    if (results.empty() && !name.empty()) {
+        int maxTypos = name.size() <= 4 ? 1 : (name.size() <= 8 ? 2 : 3);
+        vector<Student> similar;
+        for (const NameMatch& match : manager.fuzzyNameSearch(name, maxTypos, 20)) {
+            similar.push_back(match.student);
+        }
+        if (!similar.empty()) {
+            cout << "\nDid you mean (closest spellings first):" << endl;
+            TableFormatter::displayStudents(similar);
+        }
+    }
+    
     pause();
 }
 
@@ -419,39 +477,46 @@ void sortStudentsMenu(StudentManager& manager) {
     cout << "6. ID" << endl;
     cout << "7. Name" << endl;
     
-    cout << "\nChoice: ";
-    int choice = Utils::getInt();
-    
-    SortField field;
-    bool validChoice = true;
-    
-    switch (choice) {
-        case 1: field = SortField::SEX; break;
-        case 2: field = SortField::AGE; break;
-        case 3: field = SortField::GPA; break;
-        case 4: field = SortField::DEPARTMENT; break;
-        case 5: field = SortField::YEAR_OF_STUDY; break;
-        case 6: field = SortField::ID; break;
-        case 7: field = SortField::NAME; break;
-        default:
-            cout << "\n Invalid choice!" << endl;
-            pause();
-            validChoice = false;
+    cout << "\nChoice (one or more fields by priority, e.g. 4 5 -3 7;" << endl;
+    cout << "a minus sign sorts that field descending): ";
+    istringstream choices(Utils::getLine());
+    
+    static const SortField fields[] = {
+        SortField::SEX, SortField::AGE, SortField::GPA, SortField::DEPARTMENT,
+        SortField::YEAR_OF_STUDY, SortField::ID, SortField::NAME
+    };
+    vector<SortKey> keys;
+    bool signedKey = false;
+    string token;
+    while (choices >> token) {
+        bool descending = token[0] == '-';
+        string digits = token.substr(descending ? 1 : 0);
+        int choice = digits.size() == 1 ? digits[0] - '0' : 0;
+        if (choice < 1 || choice > 7) {
+            keys.clear();
+            break;
+        }
+        keys.push_back(SortKey(fields[choice - 1], !descending));
+        signedKey = signedKey || descending;
     }
     
-    if (!validChoice) {
+    if (keys.empty()) {
+        cout << "\n Invalid choice!" << endl;
+        pause();
         return;
     }
     
-    cout << "\nSort order:" << endl;
-    cout << "1. Ascending" << endl;
-    cout << "2. Descending" << endl;
-    cout << "Choice: ";
-    int orderChoice = Utils::getInt();
-    bool ascending = (orderChoice == 1);
+    if (keys.size() == 1 && !signedKey) {
+        cout << "\nSort order:" << endl;
+        cout << "1. Ascending" << endl;
+        cout << "2. Descending" << endl;
+        cout << "Choice: ";
+        int orderChoice = Utils::getInt();
+        keys[0].ascending = (orderChoice == 1);
+    }
     
     vector<Student> students = manager.getAllStudents();
-    Sorter::sort(students, field, ascending);
+    Sorter::sort(students, keys);
     
     clearScreen();
     cout << "\n Sorted Students:" << endl;
@@ -469,7 +534,7 @@ void gradeStudentMenu(StudentManager& manager) {
     cout << "\nEnter Student ID: ";
     string id = Utils::getLine();
     
-    Student* student = manager.getStudent(id);
+    const Student* student = manager.getStudent(id);
     if (!student) {
         cout << "\n Student not found!" << endl;
         pause();
@@ -545,8 +610,36 @@ void viewAllStudentsMenu(StudentManager& manager) {
     cout << "║                   ALL STUDENTS                                 ║" << endl;
     cout << "╚════════════════════════════════════════════════════════════════╝" << endl;
     
-    vector<Student> students = manager.getAllStudents();
-    TableFormatter::displayStudents(students);
+    const int pageSize = 20;
+    int totalStudents = manager.getStudentCount();
+    int pageCount = max(1, (totalStudents + pageSize - 1) / pageSize);
+    int page = 0;
+    
+    while (true) {
+        vector<Student> students = manager.getStudentsPage(page, pageSize);
+        TableFormatter::displayStudents(students);
+        
+        if (pageCount == 1) {
+            break;
+        }
+        
+        cout << "Page " << (page + 1) << " of " << pageCount
+             << " (n = next, p = previous, number = jump to page, q = quit): ";
+        string input = Utils::getLine();
+        
+        if (input == "n" || input == "N") {
+            if (page + 1 < pageCount) page++;
+        } else if (input == "p" || input == "P") {
+            if (page > 0) page--;
+        } else if (!input.empty() && input.size() < 10 && all_of(input.begin(), input.end(), ::isdigit)) {
+            int requested = stoi(input);
+            if (requested >= 1 && requested <= pageCount) page = requested - 1;
+        } else if (input == "q" || input == "Q") {
+            return;
+        }
+        
+        clearScreen();
+    }
     
     pause();
 }